@@ -0,0 +1,156 @@
+#include "allocationcounter.h"
+
+// system includes
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <malloc.h>
+
+extern "C" {
+void *__libc_malloc(std::size_t size);
+void *__libc_calloc(std::size_t count, std::size_t size);
+void *__libc_realloc(void *ptr, std::size_t size);
+void *__libc_memalign(std::size_t alignment, std::size_t size);
+void __libc_free(void *ptr);
+}
+
+namespace {
+std::atomic<std::size_t> allocations;
+std::atomic<std::size_t> frees;
+std::atomic<std::size_t> allocatedBytes;
+std::atomic<std::size_t> current;
+std::atomic<std::size_t> peak;
+
+// plain int with initial-exec tls, touching it must not allocate
+thread_local int ignoreDepth;
+
+void accountAllocation(void *ptr, std::size_t size)
+{
+    if (!ptr)
+        return;
+
+    if (!ignoreDepth)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    const auto now = current.fetch_add(malloc_usable_size(ptr), std::memory_order_relaxed) + malloc_usable_size(ptr);
+    auto previous = peak.load(std::memory_order_relaxed);
+    while (now > previous && !peak.compare_exchange_weak(previous, now, std::memory_order_relaxed));
+}
+
+void accountFree(void *ptr)
+{
+    if (!ptr)
+        return;
+
+    if (!ignoreDepth)
+        frees.fetch_add(1, std::memory_order_relaxed);
+
+    current.fetch_sub(malloc_usable_size(ptr), std::memory_order_relaxed);
+}
+} // namespace
+
+extern "C" {
+
+void *malloc(std::size_t size)
+{
+    const auto ptr = __libc_malloc(size);
+    accountAllocation(ptr, size);
+    return ptr;
+}
+
+void *calloc(std::size_t count, std::size_t size)
+{
+    const auto ptr = __libc_calloc(count, size);
+    accountAllocation(ptr, count * size);
+    return ptr;
+}
+
+void *realloc(void *ptr, std::size_t size)
+{
+    if (!ptr)
+        return malloc(size);
+
+    // growing in place is no new allocation
+    const auto previousSize = malloc_usable_size(ptr);
+    const auto result = __libc_realloc(ptr, size);
+    if (!result)
+        return nullptr;
+
+    if (result == ptr)
+    {
+        current.fetch_add(malloc_usable_size(result) - previousSize, std::memory_order_relaxed);
+        return result;
+    }
+
+    current.fetch_sub(previousSize, std::memory_order_relaxed);
+    if (!ignoreDepth)
+        frees.fetch_add(1, std::memory_order_relaxed);
+    accountAllocation(result, size);
+    return result;
+}
+
+void *memalign(std::size_t alignment, std::size_t size)
+{
+    const auto ptr = __libc_memalign(alignment, size);
+    accountAllocation(ptr, size);
+    return ptr;
+}
+
+void *aligned_alloc(std::size_t alignment, std::size_t size)
+{
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, std::size_t alignment, std::size_t size)
+{
+    if (alignment % sizeof(void *) || (alignment & (alignment - 1)))
+        return EINVAL;
+
+    *ptr = memalign(alignment, size);
+    return *ptr ? 0 : ENOMEM;
+}
+
+void free(void *ptr)
+{
+    accountFree(ptr);
+    __libc_free(ptr);
+}
+
+} // extern "C"
+
+AllocationCounter::Snapshot AllocationCounter::snapshot()
+{
+    return Snapshot {
+        .allocations = allocations.load(std::memory_order_relaxed),
+        .frees = frees.load(std::memory_order_relaxed),
+        .bytes = allocatedBytes.load(std::memory_order_relaxed),
+    };
+}
+
+std::size_t AllocationCounter::currentBytes()
+{
+    return current.load(std::memory_order_relaxed);
+}
+
+std::size_t AllocationCounter::peakBytes()
+{
+    return peak.load(std::memory_order_relaxed);
+}
+
+void AllocationCounter::resetPeak()
+{
+    peak.store(current.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+AllocationCounter::Ignore::Ignore()
+{
+    ignoreDepth++;
+}
+
+AllocationCounter::Ignore::~Ignore()
+{
+    ignoreDepth--;
+}
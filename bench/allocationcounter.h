@@ -0,0 +1,49 @@
+#pragma once
+
+// system includes
+#include <cstddef>
+
+//! Counts heap allocations of the whole process by replacing malloc() and friends (glibc only).
+//! Allocations of threads holding an Ignore (the loopback server) are not counted, their bytes
+//! still show up in currentBytes() and peakBytes()
+class AllocationCounter
+{
+public:
+    struct Snapshot
+    {
+        std::size_t allocations{}; // malloc(), calloc(), realloc() to a new block, aligned variants
+        std::size_t frees{};
+        std::size_t bytes{}; // requested sizes of the counted allocations
+    };
+
+    static Snapshot snapshot();
+
+    //! Heap bytes in use right now, by malloc_usable_size()
+    static std::size_t currentBytes();
+    //! Highest currentBytes() since the last resetPeak()
+    static std::size_t peakBytes();
+    static void resetPeak();
+
+    //! Allocations of the calling thread are not counted while an instance lives
+    class Ignore
+    {
+    public:
+        Ignore();
+        ~Ignore();
+        Ignore(const Ignore &) = delete;
+        Ignore &operator=(const Ignore &) = delete;
+    };
+};
+
+//! Allocations made between construction and the call to allocations()
+class AllocationScope
+{
+public:
+    AllocationScope() : m_begin{AllocationCounter::snapshot()} {}
+
+    std::size_t allocations() const { return AllocationCounter::snapshot().allocations - m_begin.allocations; }
+    std::size_t bytes() const { return AllocationCounter::snapshot().bytes - m_begin.bytes; }
+
+private:
+    const AllocationCounter::Snapshot m_begin;
+};
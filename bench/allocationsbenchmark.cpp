@@ -0,0 +1,111 @@
+// system includes
+#include <array>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+// local includes
+#include "asynchttprequest.h"
+#include "allocationcounter.h"
+#include "benchmark.h"
+#include "loopbackserver.h"
+
+namespace bench {
+namespace {
+enum class Call
+{
+    Start,     // start(url), the body goes into buffer()
+    StartInto, // startInto(responseBuffer, url)
+    RetryInto, // retryInto(responseBuffer)
+};
+
+const char *callName(Call call)
+{
+    switch (call)
+    {
+    case Call::Start: return "start()";
+    case Call::StartInto: return "startInto()";
+    case Call::RetryInto: return "retryInto()";
+    }
+    return "unknown";
+}
+
+// static like the status buffers this is meant for
+std::array<char, 2048> responseBuffer;
+
+std::expected<void, std::string> startCycle(AsyncHttpRequest &request, Call call, const std::string &url)
+{
+    switch (call)
+    {
+    case Call::Start: return request.start(url);
+    case Call::StartInto: return request.startInto(responseBuffer, url);
+    case Call::RetryInto: return request.retryInto(responseBuffer);
+    }
+    return std::unexpected("unknown call");
+}
+} // namespace
+
+Result runAllocations(const Options &options)
+{
+    std::printf("allocations: heap allocations of a steady state request cycle on a kept-alive connection,\n"
+                "from the start call until a polled AsyncHttpRequest finished, %zu byte response buffer\n\n",
+                responseBuffer.size());
+
+    LoopbackServer server;
+
+    Table table{{"call", "body", "cycles", "allocations", "bytes"}};
+    Result result;
+
+    for (const auto call : {Call::Start, Call::StartInto, Call::RetryInto})
+        for (const std::size_t size : {std::size_t{64}, std::size_t{1024}})
+        {
+            AsyncHttpRequest asyncRequest{AsyncHttpRequest::Polled{}, "benchAllocations"};
+            asyncRequest.setSizeLimit(responseBuffer.size());
+
+            const auto url = server.url("/bytes/" + std::to_string(size));
+            const auto expected = LoopbackServer::pattern(size);
+
+            // connects and lets every buffer grow to its steady state size
+            for (int i = 0; i < 3; i++)
+            {
+                if (auto started = asyncRequest.startInto(responseBuffer, url); !started)
+                    return { .ok = false, .error = "startInto() failed: " + started.error() };
+                if (auto finished = pollFinished(asyncRequest); !finished.ok)
+                    return finished;
+            }
+
+            const std::size_t count = options.quick ? 20 : 1000;
+            std::size_t allocations{};
+            std::size_t bytes{};
+
+            for (std::size_t i = 0; i < count; i++)
+            {
+                const AllocationScope scope;
+
+                if (auto started = startCycle(asyncRequest, call, url); !started)
+                    return { .ok = false, .error = std::string{callName(call)} + " failed: " + started.error() };
+                if (auto finished = pollFinished(asyncRequest); !finished.ok)
+                    return finished;
+
+                allocations += scope.allocations();
+                bytes += scope.bytes();
+
+                if (auto checked = checkResponse(asyncRequest, size); !checked.ok)
+                    return checked;
+
+                const std::string_view body = call == Call::Start ? std::string_view{asyncRequest.buffer()} : std::string_view{responseBuffer.data(), size};
+                if (body != expected)
+                    return { .ok = false, .error = std::string{callName(call)} + " delivered a different body" };
+            }
+
+            table.row({ callName(call), std::to_string(size), std::to_string(count), std::to_string(allocations), std::to_string(bytes) });
+
+            if (call == Call::RetryInto && allocations)
+                result = { .ok = false, .error = "retryInto() cycles allocated " + std::to_string(allocations) + " times" };
+        }
+
+    table.print();
+
+    return result;
+}
+} // namespace bench
@@ -0,0 +1,126 @@
+#include "benchmark.h"
+
+// system includes
+#include <cstdio>
+#include <ctime>
+#include <thread>
+
+// local includes
+#include "asynchttprequest.h"
+
+using namespace std::chrono_literals;
+
+namespace bench {
+namespace {
+std::chrono::nanoseconds cpuTime(clockid_t clock)
+{
+    timespec time{};
+    clock_gettime(clock, &time);
+    return std::chrono::seconds{time.tv_sec} + std::chrono::nanoseconds{time.tv_nsec};
+}
+} // namespace
+
+std::chrono::nanoseconds threadCpuTime()
+{
+    return cpuTime(CLOCK_THREAD_CPUTIME_ID);
+}
+
+std::chrono::nanoseconds processCpuTime()
+{
+    return cpuTime(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+Result fetch(AsyncHttpRequest &request, const std::string &url, std::size_t size)
+{
+    if (auto result = request.start(url); !result)
+        return { .ok = false, .error = "start() failed: " + result.error() };
+
+    if (!request.waitFinished(10s))
+        return { .ok = false, .error = "request did not finish within 10s" };
+
+    return checkResponse(request, size);
+}
+
+Result fetchPolled(AsyncHttpRequest &request, const std::string &url, std::size_t size, std::string_view serverCert)
+{
+    if (auto result = request.start(url, HTTP_METHOD_GET, {}, {}, 0, serverCert); !result)
+        return { .ok = false, .error = "start() failed: " + result.error() };
+
+    if (auto result = pollFinished(request); !result.ok)
+        return result;
+
+    return checkResponse(request, size);
+}
+
+Result pollFinished(AsyncHttpRequest &request)
+{
+    const auto deadline = Clock::now() + 10s;
+    while (request.poll())
+    {
+        if (Clock::now() > deadline)
+            return { .ok = false, .error = "request did not finish within 10s" };
+
+        // sleeping does not count as cpu time of this thread
+        if (const auto due = request.nextPollDue())
+            std::this_thread::sleep_for(*due - espchrono::millis_clock::now());
+    }
+
+    return {};
+}
+
+Result checkResponse(AsyncHttpRequest &request, std::size_t size)
+{
+    if (auto result = request.result(); !result)
+        return { .ok = false, .error = "request failed: " + result.error() };
+
+    if (request.statusCode() != 200 || request.responseSize() != size)
+        return { .ok = false, .error = "unexpected response: status " + std::to_string(request.statusCode()) +
+                                       ", " + std::to_string(request.responseSize()) + " bytes" };
+
+    return {};
+}
+
+std::string ms(std::chrono::nanoseconds duration)
+{
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.2f", std::chrono::duration<double, std::milli>{duration}.count());
+    return buf;
+}
+
+std::string kib(std::size_t bytes)
+{
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.1f", bytes / 1024.);
+    return buf;
+}
+
+void Table::print() const
+{
+    std::vector<std::size_t> widths;
+    for (const auto &row : m_rows)
+        for (std::size_t i = 0; i < row.size(); i++)
+        {
+            if (widths.size() <= i)
+                widths.push_back(0);
+            widths[i] = std::max(widths[i], row[i].size());
+        }
+
+    for (std::size_t r = 0; r < m_rows.size(); r++)
+    {
+        for (std::size_t i = 0; i < m_rows[r].size(); i++)
+            std::printf(i ? "  %*s" : "%-*s", int(widths[i]), m_rows[r][i].c_str());
+        std::printf("\n");
+
+        if (r == 0)
+        {
+            std::size_t total{};
+            for (const auto width : widths)
+                total += width + 2;
+            std::printf("%s\n", std::string(total - 2, '-').c_str());
+        }
+    }
+
+    std::printf("\n");
+    std::fflush(stdout);
+}
+} // namespace bench
@@ -0,0 +1,79 @@
+#pragma once
+
+// system includes
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class AsyncHttpRequest;
+
+namespace bench {
+struct Options
+{
+    bool quick{}; // few iterations, for the ctest smoke run
+};
+
+//! A failed benchmark makes the executable (and ctest) fail
+struct Result
+{
+    bool ok{true};
+    std::string error;
+};
+
+using Clock = std::chrono::steady_clock;
+
+//! Cpu time consumed by the calling thread
+std::chrono::nanoseconds threadCpuTime();
+//! Cpu time consumed by all threads of the process
+std::chrono::nanoseconds processCpuTime();
+
+//! Value below which fraction of the samples lie (nearest rank), samples get sorted
+template<typename T>
+T percentile(std::vector<T> &samples, double fraction)
+{
+    if (samples.empty())
+        return T{};
+
+    std::sort(std::begin(samples), std::end(samples));
+    const auto rank = std::size_t(fraction * (samples.size() - 1) + 0.5);
+    return samples[std::min(rank, samples.size() - 1)];
+}
+
+//! Starts one request and waits for it, the response has to be size bytes with status 200
+Result fetch(AsyncHttpRequest &request, const std::string &url, std::size_t size);
+//! The same for a polled request, the calling thread polls it and sleeps in between
+Result fetchPolled(AsyncHttpRequest &request, const std::string &url, std::size_t size, std::string_view serverCert = {});
+//! Polls a started polled request until it finished, sleeping in between
+Result pollFinished(AsyncHttpRequest &request);
+//! The finished request has to have succeeded with status 200 and size bytes of body
+Result checkResponse(AsyncHttpRequest &request, std::size_t size);
+
+//! Formats a duration as milliseconds with 2 decimals
+std::string ms(std::chrono::nanoseconds duration);
+std::string kib(std::size_t bytes);
+
+//! Column aligned plain text table on stdout
+class Table
+{
+public:
+    explicit Table(std::vector<std::string> header) : m_rows{std::move(header)} {}
+
+    void row(std::vector<std::string> row) { m_rows.push_back(std::move(row)); }
+    void print() const;
+
+private:
+    std::vector<std::vector<std::string>> m_rows;
+};
+
+Result runAllocations(const Options &options);
+Result runHandshake(const Options &options);
+Result runHeaders(const Options &options);
+Result runLatency(const Options &options);
+Result runPathologies(const Options &options);
+Result runPriority(const Options &options);
+Result runRequests(const Options &options);
+Result runSubmission(const Options &options);
+} // namespace bench
@@ -0,0 +1,108 @@
+// system includes
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// local includes
+#include "asynchttprequest.h"
+#include "benchmark.h"
+#include "loopbackserver.h"
+
+namespace bench {
+namespace {
+constexpr std::size_t BODY_SIZE = 1024;
+
+struct Case
+{
+    const char *name;
+    LoopbackServer::Tls tls;
+    bool usePool; // the pool keeps the closed client, and with it the tls session of its transport
+};
+
+constexpr Case cases[] {
+    { "http",                           LoopbackServer::Tls::Off,               false },
+    { "https, no session cache",        LoopbackServer::Tls::WithResumption,    false },
+    { "https, server refuses sessions", LoopbackServer::Tls::WithoutResumption, true },
+    { "https, session cache",           LoopbackServer::Tls::WithResumption,    true },
+};
+
+const char *handshakeName(AsyncHttpRequest::Handshake handshake)
+{
+    switch (handshake)
+    {
+    case AsyncHttpRequest::Handshake::None: return "none";
+    case AsyncHttpRequest::Handshake::Plain: return "plain";
+    case AsyncHttpRequest::Handshake::TlsFull: return "full";
+    case AsyncHttpRequest::Handshake::TlsSessionOffered: return "session offered";
+    }
+    return "unknown";
+}
+} // namespace
+
+Result runHandshake(const Options &options)
+{
+    std::printf("handshake: a polled AsyncHttpRequest without keep-alive, every %zu byte GET connects anew\n"
+                "handshake is what the client attempted, server resumed counts the handshakes the server really resumed\n"
+                "cpu is what the polling thread spent from start() until the request finished: dns, connect, handshake and the request\n\n",
+                BODY_SIZE);
+
+    Table table{{"connection", "handshake", "requests", "server resumed", "cpu p50 ms", "cpu p99 ms", "wall p50 ms"}};
+
+    for (const auto &testCase : cases)
+    {
+        LoopbackServer server{{}, testCase.tls};
+
+        AsyncHttpRequest asyncRequest{AsyncHttpRequest::Polled{}, "benchHandshake"};
+        asyncRequest.setKeepAlive(false);
+        asyncRequest.setUsePool(testCase.usePool);
+        asyncRequest.setSizeLimit(BODY_SIZE);
+
+        const auto url = server.url("/bytes/" + std::to_string(BODY_SIZE));
+
+        // nothing to resume yet
+        if (auto result = fetchPolled(asyncRequest, url, BODY_SIZE, server.certificate()); !result.ok)
+            return result;
+
+        const std::size_t count = options.quick ? 5 : 200;
+        std::vector<std::chrono::nanoseconds> cpuTimes;
+        std::vector<Clock::duration> latencies;
+        cpuTimes.reserve(count);
+        latencies.reserve(count);
+
+        const auto handshakesBefore = server.handshakes();
+        const auto resumedBefore = server.resumedHandshakes();
+        std::string handshake;
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            const auto cpuBefore = threadCpuTime();
+            const auto started = Clock::now();
+
+            if (auto result = fetchPolled(asyncRequest, url, BODY_SIZE, server.certificate()); !result.ok)
+                return result;
+
+            cpuTimes.push_back(threadCpuTime() - cpuBefore);
+            latencies.push_back(Clock::now() - started);
+
+            const std::string name = handshakeName(asyncRequest.handshake());
+            if (handshake.empty())
+                handshake = name;
+            else if (handshake != name)
+                handshake = "mixed";
+        }
+
+        const auto handshakes = server.handshakes() - handshakesBefore;
+
+        table.row({
+            testCase.name, handshake, std::to_string(count),
+            testCase.tls == LoopbackServer::Tls::Off ? "-" : std::to_string(server.resumedHandshakes() - resumedBefore) + "/" + std::to_string(handshakes),
+            ms(percentile(cpuTimes, .5)), ms(percentile(cpuTimes, .99)), ms(percentile(latencies, .5)),
+        });
+    }
+
+    table.print();
+
+    return {};
+}
+} // namespace bench
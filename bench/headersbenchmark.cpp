@@ -0,0 +1,166 @@
+// system includes
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// local includes
+#include "asynchttpheaders.h"
+#include "allocationcounter.h"
+#include "benchmark.h"
+
+namespace bench {
+namespace {
+using Headers = std::vector<std::pair<std::string_view, std::string_view>>;
+
+// what a cdn fronted api answers with, the first n of them make up a response
+constexpr std::pair<std::string_view, std::string_view> realisticHeaders[] {
+    { "Date", "Fri, 16 Oct 2026 09:47:01 GMT" },
+    { "Content-Type", "application/json; charset=utf-8" },
+    { "Content-Length", "1432" },
+    { "Connection", "keep-alive" },
+    { "Server", "nginx/1.25.3" },
+    { "Cache-Control", "no-cache, no-store, must-revalidate" },
+    { "ETag", "W/\"598-Kb9yW2mNRxQ2Zcxlx0o3EDtVr2I\"" },
+    { "Vary", "Accept-Encoding, Origin" },
+    { "Set-Cookie", "session=8f1c2d7e9a0b4c3d; Path=/; HttpOnly; Secure; SameSite=Lax" },
+    { "Set-Cookie", "csrftoken=Qm9vZ2xlIGlzIG5vdCBhIHRva2Vu; Path=/; Secure" },
+    { "Strict-Transport-Security", "max-age=31536000; includeSubDomains" },
+    { "X-Content-Type-Options", "nosniff" },
+    { "X-Frame-Options", "DENY" },
+    { "Access-Control-Allow-Origin", "*" },
+    { "X-Request-Id", "3f9a6c2e-1b7d-4e8f-a0c5-9d2b7e4f6a13" },
+    { "Last-Modified", "Thu, 15 Oct 2026 18:02:44 GMT" },
+    { "Expires", "0" },
+    { "Pragma", "no-cache" },
+    { "Age", "0" },
+    { "Via", "1.1 varnish" },
+    { "X-Cache", "MISS" },
+    { "Referrer-Policy", "strict-origin-when-cross-origin" },
+    { "Alt-Svc", "h3=\":443\"; ma=86400" },
+    { "Accept-Ranges", "bytes" },
+    { "Content-Security-Policy", "default-src 'none'; frame-ancestors 'none'" },
+    { "Permissions-Policy", "geolocation=(), microphone=(), camera=()" },
+    { "Set-Cookie", "region=eu-central-1; Path=/; Max-Age=3600" },
+    { "X-RateLimit-Limit", "600" },
+    { "X-RateLimit-Remaining", "598" },
+    { "Report-To", "{\"group\":\"default\",\"max_age\":31536000,\"endpoints\":[{\"url\":\"https://r.example.com/a\"}]}" },
+};
+
+// with the spelling of the response, the map only finds them like that
+constexpr std::string_view lookups[] { "Content-Type", "Content-Length", "ETag", "Connection", "X-Missing" };
+
+template<typename T>
+void doNotOptimize(const T &value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+struct Measurement
+{
+    double allocations{};    // per response
+    std::size_t heapBytes{}; // held once filled, malloc_usable_size() of every block
+    std::chrono::nanoseconds fill{};
+    std::chrono::nanoseconds lookup{};
+};
+
+//! fill(store, headers) and lookup(store, name) for one kind of store, steady state means
+//! the store is reused like m_responseHeaders is from one response to the next
+template<typename Store, typename Fill, typename Lookup>
+Measurement measure(const Headers &headers, std::size_t iterations, Fill &&fill, Lookup &&lookup)
+{
+    Measurement measurement;
+
+    {
+        const auto before = AllocationCounter::currentBytes();
+        Store store;
+        fill(store, headers);
+        measurement.heapBytes = AllocationCounter::currentBytes() - before;
+    }
+
+    Store store;
+    fill(store, headers);
+
+    const AllocationScope allocations;
+    auto begin = Clock::now();
+    for (std::size_t i = 0; i < iterations; i++)
+    {
+        fill(store, headers);
+        doNotOptimize(store);
+    }
+    measurement.fill = (Clock::now() - begin) / iterations;
+    measurement.allocations = double(allocations.allocations()) / iterations;
+
+    begin = Clock::now();
+    for (std::size_t i = 0; i < iterations; i++)
+        for (const auto name : lookups)
+        {
+            const auto value = lookup(store, name);
+            doNotOptimize(value);
+        }
+    measurement.lookup = (Clock::now() - begin) / (iterations * std::size(lookups));
+
+    return measurement;
+}
+
+std::string ns(std::chrono::nanoseconds duration)
+{
+    return std::to_string(duration.count());
+}
+} // namespace
+
+Result runHeaders(const Options &options)
+{
+    std::printf("headers: response header store, std::map<std::string, std::string> as before against AsyncHttpHeaders\n"
+                "fill is clearing the store and adding every header of a response, lookup is one find() of");
+    for (const auto name : lookups)
+        std::printf(" %.*s", int(name.size()), name.data());
+    std::printf("\n\n");
+
+    Table table{{"store", "headers", "allocs/response", "heap bytes", "fill ns", "lookup ns"}};
+
+    const std::size_t iterations = options.quick ? 1000 : 200000;
+
+    for (const std::size_t count : {std::size_t{15}, std::size_t{22}, std::size_t{30}})
+    {
+        const Headers headers{std::begin(realisticHeaders), std::begin(realisticHeaders) + count};
+
+        const auto map = measure<std::map<std::string, std::string>>(headers, iterations,
+            [](auto &store, const Headers &headers){
+                store.clear();
+                for (const auto &[name, value] : headers)
+                    store.emplace(name, value);
+            },
+            [](const auto &store, std::string_view name){
+                const auto iter = store.find(std::string{name});
+                return iter == std::end(store) ? std::string_view{} : std::string_view{iter->second};
+            });
+
+        const auto arena = measure<AsyncHttpHeaders>(headers, iterations,
+            [](auto &store, const Headers &headers){
+                store.clear();
+                for (const auto &[name, value] : headers)
+                    store.append(name, value);
+            },
+            [](const auto &store, std::string_view name){
+                return store.find(name).value_or(std::string_view{});
+            });
+
+        for (const auto &[name, measurement] : {std::pair{"std::map", map}, std::pair{"AsyncHttpHeaders", arena}})
+        {
+            char allocations[32];
+            std::snprintf(allocations, sizeof(allocations), "%.1f", measurement.allocations);
+
+            table.row({ name, std::to_string(count), allocations, std::to_string(measurement.heapBytes),
+                        ns(measurement.fill), ns(measurement.lookup) });
+        }
+    }
+
+    table.print();
+
+    return {};
+}
+} // namespace bench
@@ -0,0 +1,88 @@
+// system includes
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// local includes
+#include "asynchttprequest.h"
+#include "benchmark.h"
+#include "loopbackserver.h"
+#include "sdkconfig.h"
+
+using namespace std::chrono_literals;
+
+namespace bench {
+namespace {
+constexpr std::size_t BODY_SIZE = 1024;
+
+//! GET /delayed/<ms> answers with BODY_SIZE bytes after sleeping for ms milliseconds
+bool delayedHandler(const LoopbackServer::Request &request, LoopbackServer::Connection &connection)
+{
+    unsigned delay{};
+    if (request.method != "GET" || !request.target.starts_with("/delayed/") ||
+        std::from_chars(request.target.data() + 9, request.target.data() + request.target.size(), delay).ec != std::errc{})
+        return LoopbackServer::respond(request, connection, 404, "not found\n", "text/plain");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{delay});
+
+    return LoopbackServer::respondBytes(request, connection, BODY_SIZE);
+}
+} // namespace
+
+Result runLatency(const Options &options)
+{
+    const bool fixedPoll = CONFIG_ASYNC_HTTP_POLL_INTERVAL_MIN_MS == CONFIG_ASYNC_HTTP_POLL_INTERVAL_MAX_MS;
+
+    char poll[64];
+    if (fixedPoll)
+        std::snprintf(poll, sizeof(poll), "fixed %i ms", CONFIG_ASYNC_HTTP_POLL_INTERVAL_MIN_MS);
+    else
+        std::snprintf(poll, sizeof(poll), "adaptive %i..%i ms", CONFIG_ASYNC_HTTP_POLL_INTERVAL_MIN_MS, CONFIG_ASYNC_HTTP_POLL_INTERVAL_MAX_MS);
+
+    std::printf("latency: start() to waitFinished() of a %zu byte GET, the server answers after a delay\n"
+                "poll interval: %s, asynchttpbench and asynchttpbench_fixedpoll print the two sides of the comparison\n\n",
+                BODY_SIZE, poll);
+
+    LoopbackServer server{delayedHandler};
+
+    Table table{{"poll", "server delay", "keep-alive", "requests", "p50 ms", "p99 ms", "max ms"}};
+
+    for (const auto delay : {0ms, 20ms})
+        for (const bool keepAlive : {true, false})
+        {
+            AsyncHttpRequest asyncRequest{"benchLatency"};
+            asyncRequest.setKeepAlive(keepAlive);
+            asyncRequest.setSizeLimit(BODY_SIZE);
+
+            const auto url = server.url("/delayed/" + std::to_string(delay.count()));
+
+            // creates the task and the client
+            if (auto result = fetch(asyncRequest, url, BODY_SIZE); !result.ok)
+                return result;
+
+            const std::size_t count = options.quick ? 3 : (fixedPoll ? 20 : 200);
+            std::vector<Clock::duration> latencies;
+            latencies.reserve(count);
+
+            for (std::size_t i = 0; i < count; i++)
+            {
+                const auto started = Clock::now();
+                if (auto result = fetch(asyncRequest, url, BODY_SIZE); !result.ok)
+                    return result;
+                latencies.push_back(Clock::now() - started);
+            }
+
+            table.row({
+                poll, ms(delay), keepAlive ? "on" : "off", std::to_string(count),
+                ms(percentile(latencies, .5)), ms(percentile(latencies, .99)), ms(percentile(latencies, 1.)),
+            });
+        }
+
+    table.print();
+
+    return {};
+}
+} // namespace bench
@@ -0,0 +1,495 @@
+#include "loopbackserver.h"
+
+// system includes
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// 3rdparty lib includes
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+
+// local includes
+#include "allocationcounter.h"
+
+namespace {
+constexpr std::size_t PATTERN_SIZE = 64 * 1024;
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b)
+{
+    return a.size() == b.size() && strncasecmp(a.data(), b.data(), a.size()) == 0;
+}
+
+const std::string &patternBuffer()
+{
+    static const std::string pattern = [](){
+        std::string pattern(PATTERN_SIZE, '\0');
+        for (std::size_t i = 0; i < pattern.size(); i++)
+            pattern[i] = char('a' + i % 26);
+        return pattern;
+    }();
+    return pattern;
+}
+
+const char *reasonPhrase(int status)
+{
+    switch (status)
+    {
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 500: return "Internal Server Error";
+    default: return "Unknown";
+    }
+}
+
+void trim(std::string_view &str)
+{
+    while (!str.empty() && (str.front() == ' ' || str.front() == '\t'))
+        str.remove_prefix(1);
+    while (!str.empty() && (str.back() == ' ' || str.back() == '\t'))
+        str.remove_suffix(1);
+}
+
+std::string_view nextLine(std::string_view &lines)
+{
+    const auto end = lines.find("\r\n");
+    const auto line = lines.substr(0, end);
+    lines.remove_prefix(end == std::string_view::npos ? lines.size() : end + 2);
+    return line;
+}
+
+//! Parses the head in buffer up to the empty line, false if it is malformed
+bool parseHead(std::string_view head, LoopbackServer::Request &request)
+{
+    auto line = nextLine(head);
+
+    // GET /path HTTP/1.1
+    const auto methodEnd = line.find(' ');
+    const auto targetEnd = line.rfind(' ');
+    if (methodEnd == std::string_view::npos || targetEnd == methodEnd || !line.substr(targetEnd + 1).starts_with("HTTP/1."))
+        return false;
+
+    request.method = line.substr(0, methodEnd);
+    request.target = line.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+    request.keepAlive = line.substr(targetEnd + 1) != "HTTP/1.0";
+    request.headers.clear();
+
+    while (!head.empty())
+    {
+        line = nextLine(head);
+
+        const auto colon = line.find(':');
+        if (colon == std::string_view::npos)
+            return false;
+
+        auto key = line.substr(0, colon);
+        auto value = line.substr(colon + 1);
+        trim(key);
+        trim(value);
+        request.headers.emplace_back(key, value);
+
+        if (equalsIgnoreCase(key, "Connection"))
+            request.keepAlive = !equalsIgnoreCase(value, "close");
+    }
+
+    return true;
+}
+} // namespace
+
+std::string_view LoopbackServer::Request::header(std::string_view name) const
+{
+    for (const auto &[key, value] : headers)
+        if (equalsIgnoreCase(key, name))
+            return value;
+
+    return {};
+}
+
+bool LoopbackServer::Connection::send(std::string_view data)
+{
+    while (!data.empty())
+    {
+        if (m_ssl)
+        {
+            const auto result = SSL_write(m_ssl, data.data(), int(std::min<std::size_t>(data.size(), 1 << 30)));
+            if (result <= 0)
+                return false;
+            data.remove_prefix(result);
+            continue;
+        }
+
+        const auto result = ::send(m_fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result <= 0)
+            return false;
+        data.remove_prefix(result);
+    }
+
+    return true;
+}
+
+void LoopbackServer::Connection::reset()
+{
+    // a zero linger time makes close() send a RST
+    const linger option{ .l_onoff = 1, .l_linger = 0 };
+    setsockopt(m_fd, SOL_SOCKET, SO_LINGER, &option, sizeof(option));
+}
+
+long LoopbackServer::Connection::receive(char *data, std::size_t size)
+{
+    if (m_ssl)
+        return std::max(SSL_read(m_ssl, data, int(std::min<std::size_t>(size, 1 << 30))), 0);
+
+    while (true)
+    {
+        const auto result = ::recv(m_fd, data, size, 0);
+        if (result < 0 && errno == EINTR)
+            continue;
+        return std::max<long>(result, 0);
+    }
+}
+
+LoopbackServer::LoopbackServer(Handler handler, Tls tls) :
+    m_handler{std::move(handler)}
+{
+    if (tls != Tls::Off)
+        setupTls(tls);
+
+    if (!m_handler)
+        m_handler = [](const Request &request, Connection &connection){
+            std::size_t size{};
+            if (request.method != "GET" || !request.target.starts_with("/bytes/") ||
+                std::from_chars(request.target.data() + 7, request.target.data() + request.target.size(), size).ec != std::errc{})
+                return respond(request, connection, 404, "not found\n", "text/plain");
+
+            return respondBytes(request, connection, size);
+        };
+
+    m_listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_listenFd < 0)
+        throw std::runtime_error{std::string{"socket() failed: "} + std::strerror(errno)};
+
+    const int one = 1;
+    setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+
+    socklen_t length = sizeof(address);
+    if (::bind(m_listenFd, (const sockaddr *)&address, sizeof(address)) < 0 ||
+        ::listen(m_listenFd, 128) < 0 ||
+        ::getsockname(m_listenFd, (sockaddr *)&address, &length) < 0 ||
+        ::pipe2(m_wakeupFds, O_CLOEXEC) < 0)
+    {
+        const auto error = errno;
+        ::close(m_listenFd);
+        throw std::runtime_error{std::string{"listening on 127.0.0.1 failed: "} + std::strerror(error)};
+    }
+
+    m_port = ntohs(address.sin_port);
+    m_acceptThread = std::thread{[this](){ acceptLoop(); }};
+}
+
+LoopbackServer::~LoopbackServer()
+{
+    const char quit{};
+    [[maybe_unused]] const auto result = ::write(m_wakeupFds[1], &quit, 1);
+    m_acceptThread.join();
+
+    {
+        std::lock_guard lock{m_mutex};
+        for (auto &worker : m_workers)
+            if (worker.fd >= 0)
+                ::shutdown(worker.fd, SHUT_RDWR);
+    }
+
+    reapWorkers(true);
+
+    ::close(m_listenFd);
+    ::close(m_wakeupFds[0]);
+    ::close(m_wakeupFds[1]);
+
+    SSL_CTX_free(m_tlsContext);
+}
+
+std::string LoopbackServer::url(std::string_view target) const
+{
+    std::string url{m_tlsContext ? "https://127.0.0.1:" : "http://127.0.0.1:"};
+    url += std::to_string(m_port);
+    url += target;
+    return url;
+}
+
+bool LoopbackServer::respond(const Request &request, Connection &connection, int status, std::string_view body,
+                             std::string_view contentType)
+{
+    char head[256];
+    const auto length = std::snprintf(head, sizeof(head), "HTTP/1.1 %i %s\r\nContent-Type: %.*s\r\nContent-Length: %zu\r\n%s\r\n",
+                                      status, reasonPhrase(status), int(contentType.size()), contentType.data(), body.size(),
+                                      request.keepAlive ? "" : "Connection: close\r\n");
+
+    if (!connection.send({head, std::size_t(length)}))
+        return false;
+
+    if (request.method != "HEAD" && !connection.send(body))
+        return false;
+
+    return request.keepAlive;
+}
+
+bool LoopbackServer::respondBytes(const Request &request, Connection &connection, std::size_t size)
+{
+    char head[256];
+    const auto length = std::snprintf(head, sizeof(head), "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Length: %zu\r\n%s\r\n",
+                                      size, request.keepAlive ? "" : "Connection: close\r\n");
+
+    if (!connection.send({head, std::size_t(length)}))
+        return false;
+
+    if (request.method != "HEAD")
+        for (std::size_t sent = 0; sent < size; )
+        {
+            const auto piece = std::min(size - sent, PATTERN_SIZE);
+            if (!connection.send(std::string_view{patternBuffer()}.substr(0, piece)))
+                return false;
+            sent += piece;
+        }
+
+    return request.keepAlive;
+}
+
+std::string LoopbackServer::pattern(std::size_t size)
+{
+    std::string pattern;
+    pattern.reserve(size);
+    while (pattern.size() < size)
+        pattern += std::string_view{patternBuffer()}.substr(0, std::min(size - pattern.size(), PATTERN_SIZE));
+    return pattern;
+}
+
+void LoopbackServer::acceptLoop()
+{
+    AllocationCounter::Ignore ignore;
+
+    while (true)
+    {
+        pollfd fds[] {
+            { .fd = m_listenFd, .events = POLLIN, .revents = 0 },
+            { .fd = m_wakeupFds[0], .events = POLLIN, .revents = 0 },
+        };
+
+        if (::poll(fds, 2, -1) < 0 && errno != EINTR)
+            return;
+
+        if (fds[1].revents)
+            return;
+
+        if (!(fds[0].revents & POLLIN))
+            continue;
+
+        const auto fd = ::accept4(m_listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0)
+            continue;
+
+        const int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        m_connections++;
+
+        reapWorkers(false);
+
+        std::lock_guard lock{m_mutex};
+        auto &worker = m_workers.emplace_back();
+        worker.fd = fd;
+        worker.thread = std::thread{[this, &worker](){ serve(worker); }};
+    }
+}
+
+void LoopbackServer::serve(Worker &worker)
+{
+    AllocationCounter::Ignore ignore;
+
+    SSL *ssl{};
+    bool established{true};
+
+    if (m_tlsContext)
+    {
+        // blocking, the handshake runs on this thread like everything else of the connection
+        ssl = SSL_new(m_tlsContext);
+        SSL_set_fd(ssl, worker.fd);
+        established = SSL_accept(ssl) == 1;
+        ERR_clear_error();
+
+        if (established)
+        {
+            m_handshakes++;
+            if (SSL_session_reused(ssl))
+                m_resumedHandshakes++;
+        }
+    }
+
+    if (established)
+    {
+        Connection connection{worker.fd, ssl};
+        serveRequests(connection);
+    }
+
+    if (ssl)
+    {
+        SSL_shutdown(ssl);
+        SSL_free(ssl);
+    }
+
+    {
+        std::lock_guard lock{m_mutex};
+        ::close(worker.fd);
+        worker.fd = -1;
+    }
+
+    worker.done = true;
+}
+
+void LoopbackServer::serveRequests(Connection &connection)
+{
+    std::string buffer;
+    Request request;
+    char data[4096];
+
+    while (true)
+    {
+        std::size_t headEnd;
+        while ((headEnd = buffer.find("\r\n\r\n")) == std::string::npos)
+        {
+            const auto result = connection.receive(data, sizeof(data));
+            if (result <= 0)
+                return;
+            buffer.append(data, result);
+        }
+
+        if (!parseHead(std::string_view{buffer}.substr(0, headEnd), request))
+        {
+            LoopbackServer::respond(request, connection, 400, "bad request\n", "text/plain");
+            return;
+        }
+
+        buffer.erase(0, headEnd + 4);
+
+        std::size_t contentLength{};
+        if (const auto value = request.header("Content-Length"); !value.empty())
+            std::from_chars(value.data(), value.data() + value.size(), contentLength);
+
+        while (buffer.size() < contentLength)
+        {
+            const auto result = connection.receive(data, sizeof(data));
+            if (result <= 0)
+                return;
+            buffer.append(data, result);
+        }
+
+        request.body = buffer.substr(0, contentLength);
+        buffer.erase(0, contentLength);
+
+        if (!m_handler(request, connection) || !request.keepAlive)
+            return;
+    }
+}
+
+void LoopbackServer::reapWorkers(bool all)
+{
+    std::list<Worker> finished;
+
+    {
+        std::lock_guard lock{m_mutex};
+        for (auto iter = std::begin(m_workers); iter != std::end(m_workers); )
+        {
+            const auto next = std::next(iter);
+            if (all || iter->done)
+                finished.splice(std::end(finished), m_workers, iter);
+            iter = next;
+        }
+    }
+
+    for (auto &worker : finished)
+        worker.thread.join();
+}
+
+void LoopbackServer::setupTls(Tls tls)
+{
+    const auto fail = [](const char *what){
+        char error[256];
+        ERR_error_string_n(ERR_get_error(), error, sizeof(error));
+        throw std::runtime_error{std::string{what} + " failed: " + error};
+    };
+
+    EVP_PKEY *key = EVP_EC_gen("P-256");
+    X509 *cert = X509_new();
+    if (!key || !cert)
+        fail("generating the key");
+
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), -60);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 24 * 60 * 60);
+    X509_set_pubkey(cert, key);
+
+    const auto name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char *)"127.0.0.1", -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+
+    X509V3_CTX ctx;
+    X509V3_set_ctx_nodb(&ctx);
+    X509V3_set_ctx(&ctx, cert, cert, nullptr, nullptr, 0);
+    for (const auto &[nid, value] : {std::pair{NID_subject_alt_name, "IP:127.0.0.1"}, std::pair{NID_basic_constraints, "critical,CA:TRUE"}})
+    {
+        X509_EXTENSION *extension = X509V3_EXT_conf_nid(nullptr, &ctx, nid, value);
+        if (!extension)
+            fail("adding a certificate extension");
+        X509_add_ext(cert, extension, -1);
+        X509_EXTENSION_free(extension);
+    }
+
+    if (!X509_sign(cert, key, EVP_sha256()))
+        fail("signing the certificate");
+
+    BIO *bio = BIO_new(BIO_s_mem());
+    PEM_write_bio_X509(bio, cert);
+    char *pem{};
+    const auto length = BIO_get_mem_data(bio, &pem);
+    m_certificate.assign(pem, length);
+    BIO_free(bio);
+
+    m_tlsContext = SSL_CTX_new(TLS_server_method());
+    if (!m_tlsContext || SSL_CTX_use_certificate(m_tlsContext, cert) != 1 || SSL_CTX_use_PrivateKey(m_tlsContext, key) != 1)
+        fail("setting up the tls context");
+
+    X509_free(cert);
+    EVP_PKEY_free(key);
+
+    SSL_CTX_set_options(m_tlsContext, SSL_OP_IGNORE_UNEXPECTED_EOF);
+
+    if (tls == Tls::WithoutResumption)
+    {
+        SSL_CTX_set_session_cache_mode(m_tlsContext, SSL_SESS_CACHE_OFF);
+        SSL_CTX_set_options(m_tlsContext, SSL_OP_NO_TICKET);
+        SSL_CTX_set_num_tickets(m_tlsContext, 0);
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+// system includes
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// 3rdparty lib includes
+#include <openssl/types.h>
+
+//! HTTP/1.1 server on 127.0.0.1 for the benchmarks, every connection is served by a thread of its own
+class LoopbackServer
+{
+public:
+    enum class Tls
+    {
+        Off,
+        WithoutResumption, // neither session ids nor tickets, every handshake is a full one
+        WithResumption,
+    };
+
+    struct Request
+    {
+        std::string method;
+        std::string target;
+        std::vector<std::pair<std::string, std::string>> headers;
+        std::string body;
+        bool keepAlive{}; // what the client asked for
+
+        //! Case-insensitive, empty if missing
+        std::string_view header(std::string_view name) const;
+    };
+
+    //! One accepted connection, handlers write their response through it
+    class Connection
+    {
+        friend class LoopbackServer;
+
+    public:
+        explicit Connection(int fd, SSL *ssl = nullptr) : m_fd{fd}, m_ssl{ssl} {}
+
+        //! Blocks until everything was written, false once the peer is gone
+        bool send(std::string_view data);
+        //! The connection is closed with a RST instead of a FIN, the handler has to return false afterwards
+        void reset();
+        int fd() const { return m_fd; }
+
+    private:
+        //! Up to size bytes of the request, 0 once the peer closed the connection
+        long receive(char *data, std::size_t size);
+
+        int m_fd;
+        SSL *m_ssl;
+    };
+
+    //! Writes the response to request, returns false to close the connection afterwards
+    using Handler = std::function<bool(const Request &request, Connection &connection)>;
+
+    //! Without a handler GET /bytes/<n> is answered with n bytes of body. With tls a self-signed
+    //! certificate for 127.0.0.1 is generated, see certificate()
+    explicit LoopbackServer(Handler handler = {}, Tls tls = Tls::Off);
+    ~LoopbackServer();
+
+    uint16_t port() const { return m_port; }
+    //! https:// with tls
+    std::string url(std::string_view target) const;
+    //! Pem of the self-signed certificate, for the cert_pem of the clients
+    std::string_view certificate() const { return m_certificate; }
+
+    //! Connections accepted so far
+    std::size_t connections() const { return m_connections; }
+    //! Completed tls handshakes and how many of them resumed a session
+    std::size_t handshakes() const { return m_handshakes; }
+    std::size_t resumedHandshakes() const { return m_resumedHandshakes; }
+
+    //! Writes a complete response with Content-Length, keeps the connection when the client asked for it
+    static bool respond(const Request &request, Connection &connection, int status, std::string_view body,
+                        std::string_view contentType = "application/octet-stream");
+    //! The same with size bytes of a repeating pattern as body
+    static bool respondBytes(const Request &request, Connection &connection, std::size_t size);
+    //! size bytes of the pattern respondBytes() sends
+    static std::string pattern(std::size_t size);
+
+private:
+    struct Worker
+    {
+        std::thread thread;
+        std::atomic<bool> done{};
+        int fd{-1};
+    };
+
+    void acceptLoop();
+    void serve(Worker &worker);
+    void serveRequests(Connection &connection);
+    void reapWorkers(bool all);
+    void setupTls(Tls tls);
+
+    Handler m_handler;
+    SSL_CTX *m_tlsContext{};
+    std::string m_certificate;
+    int m_listenFd{-1};
+    int m_wakeupFds[2]{-1, -1};
+    uint16_t m_port{};
+    std::atomic<std::size_t> m_connections{};
+    std::atomic<std::size_t> m_handshakes{};
+    std::atomic<std::size_t> m_resumedHandshakes{};
+    std::mutex m_mutex;
+    std::list<Worker> m_workers; // guarded by m_mutex
+    std::thread m_acceptThread;
+};
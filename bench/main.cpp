@@ -0,0 +1,88 @@
+// system includes
+#include <cstdio>
+#include <algorithm>
+#include <csignal>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+// esp-idf includes
+#include <esp_log.h>
+
+// local includes
+#include "benchmark.h"
+
+namespace {
+struct Benchmark
+{
+    const char *name;
+    const char *description;
+    bench::Result (*run)(const bench::Options &options);
+};
+
+constexpr Benchmark benchmarks[] {
+    { "allocations", "heap allocations of steady state start(), startInto() and retryInto() cycles, fails unless retryInto() makes none", bench::runAllocations },
+    { "handshake", "cpu time of requests on new connections, plain, full tls handshakes and offered tls sessions", bench::runHandshake },
+    { "headers", "memory, fill and lookup time of AsyncHttpHeaders against std::map for 15 to 30 response headers", bench::runHeaders },
+    { "latency", "p50 and p99 latency of single requests under the configured poll interval", bench::runLatency },
+    { "pathologies", "cpu, body delivery and buffer growth against servers with tiny segments and chunks, drips, lies and resets", bench::runPathologies },
+    { "priority", "latency of interactive requests competing with bulk downloads for a worker task, with and without priorities", bench::runPriority },
+    { "requests", "requests per second, latency, allocations and peak heap by body size and keep-alive", bench::runRequests },
+    { "submission", "time and allocations of start() with url and headers against start(prepared)", bench::runSubmission },
+};
+
+void usage(const char *name)
+{
+    std::printf("usage: %s [--quick] [--list] [benchmark...]\n", name);
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    bench::Options options;
+    std::vector<std::string_view> selected;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string_view arg{argv[i]};
+        if (arg == "--quick")
+            options.quick = true;
+        else if (arg == "--list")
+        {
+            for (const auto &benchmark : benchmarks)
+                std::printf("%-16s %s\n", benchmark.name, benchmark.description);
+            return 0;
+        }
+        else if (arg.starts_with("-"))
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        else
+            selected.push_back(arg);
+    }
+
+    esp_log_level_set("*", ESP_LOG_WARN);
+
+    // the tls side of the loopback server writes through openssl, which does not pass MSG_NOSIGNAL
+    std::signal(SIGPIPE, SIG_IGN);
+
+    int failed{};
+
+    for (const auto &benchmark : benchmarks)
+    {
+        if (!selected.empty() && std::find(std::begin(selected), std::end(selected), benchmark.name) == std::end(selected))
+            continue;
+
+        std::printf("== %s ==\n", benchmark.name);
+        std::fflush(stdout);
+
+        if (const auto result = benchmark.run(options); !result.ok)
+        {
+            std::printf("%s FAILED: %s\n\n", benchmark.name, result.error.c_str());
+            failed++;
+        }
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,79 @@
+#include "mockserver.h"
+
+// system includes
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+MockServer::MockServer(const MockScript &script) :
+    m_script{script},
+    m_server{[this](const LoopbackServer::Request &request, LoopbackServer::Connection &connection){
+        return respond(request, connection);
+    }}
+{
+    const auto body = LoopbackServer::pattern(m_script.bodySize);
+
+    m_head = "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\n";
+
+    switch (m_script.framing)
+    {
+    case MockScript::Framing::ContentLength:
+        m_head += "Content-Length: " + std::to_string(m_script.declaredLength.value_or(body.size())) + "\r\n";
+        m_body = body;
+        break;
+    case MockScript::Framing::Chunked:
+        m_head += "Transfer-Encoding: chunked\r\n";
+        for (std::size_t offset = 0; offset < body.size(); offset += std::max<std::size_t>(m_script.chunkSize, 1))
+        {
+            const auto chunk = std::string_view{body}.substr(offset, std::max<std::size_t>(m_script.chunkSize, 1));
+            char size[24];
+            std::snprintf(size, sizeof(size), "%zx\r\n", chunk.size());
+            (m_body += size) += chunk;
+            m_body += "\r\n";
+        }
+        m_body += "0\r\n\r\n";
+        break;
+    case MockScript::Framing::UntilClose:
+        m_head += "Connection: close\r\n";
+        m_body = body;
+        break;
+    }
+
+    m_head += "\r\n";
+}
+
+bool MockServer::respond(const LoopbackServer::Request &request, LoopbackServer::Connection &connection) const
+{
+    if (!connection.send(m_head))
+        return false;
+
+    const std::string_view body{m_body};
+    const auto end = std::min(body.size(), m_script.resetAfter.value_or(body.size()));
+    const auto segment = m_script.segmentSize ? m_script.segmentSize : (m_script.bytesPerSecond ? 1 : std::max<std::size_t>(end, 1));
+    const auto started = std::chrono::steady_clock::now();
+
+    for (std::size_t sent = 0; sent < end; )
+    {
+        const auto piece = std::min(end - sent, segment);
+
+        if (m_script.bytesPerSecond)
+            std::this_thread::sleep_until(started + std::chrono::microseconds{sent * 1000000 / m_script.bytesPerSecond});
+
+        if (!connection.send(body.substr(sent, piece)))
+            return false;
+        sent += piece;
+    }
+
+    if (m_script.resetAfter && *m_script.resetAfter < body.size())
+    {
+        connection.reset();
+        return false;
+    }
+
+    // a lying Content-Length or a body delimited by the end of the connection
+    if (m_script.declaredLength || m_script.framing == MockScript::Framing::UntilClose)
+        return false;
+
+    return request.keepAlive;
+}
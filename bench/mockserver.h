@@ -0,0 +1,49 @@
+#pragma once
+
+// system includes
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// local includes
+#include "loopbackserver.h"
+
+//! How MockServer misbehaves, every request is answered with the same scripted response
+struct MockScript
+{
+    enum class Framing
+    {
+        ContentLength,
+        Chunked,
+        UntilClose, // neither Content-Length nor chunked, the body ends with the connection
+    };
+
+    std::size_t bodySize{};
+    Framing framing{Framing::ContentLength};
+    std::size_t chunkSize{1024};                // chunked only
+    std::size_t segmentSize{};                  // bytes per send(), with TCP_NODELAY each one leaves as a segment of its own, 0 sends at once
+    std::size_t bytesPerSecond{};               // drips the body at this rate (single bytes without a segmentSize), 0 sends as fast as possible
+    std::optional<std::size_t> declaredLength{}; // Content-Length announced instead of bodySize, the connection is closed after the body
+    std::optional<std::size_t> resetAfter{};     // bytes of the encoded body after which the connection is reset
+};
+
+//! LoopbackServer answering with a MockScript, for driving AsyncHttpRequest through network pathologies.
+//! The body is LoopbackServer::pattern(bodySize)
+class MockServer
+{
+public:
+    explicit MockServer(const MockScript &script);
+
+    std::string url() const { return m_server.url("/mock"); }
+    std::size_t connections() const { return m_server.connections(); }
+
+private:
+    bool respond(const LoopbackServer::Request &request, LoopbackServer::Connection &connection) const;
+
+    const MockScript m_script;
+    //! status line, headers and body as they go over the wire
+    std::string m_head;
+    std::string m_body;
+    LoopbackServer m_server; // last, its threads use the members above
+};
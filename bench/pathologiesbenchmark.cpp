@@ -0,0 +1,152 @@
+// system includes
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <vector>
+
+// esp-idf includes
+#include <esp_log.h>
+
+// local includes
+#include "asynchttprequest.h"
+#include "allocationcounter.h"
+#include "benchmark.h"
+#include "mockserver.h"
+
+namespace bench {
+namespace {
+constexpr std::size_t BODY_SIZE = 16 * 1024;
+constexpr std::size_t SIZE_LIMIT = 256 * 1024;
+
+struct Case
+{
+    const char *name;
+    MockScript script;
+    bool succeeds;
+    std::size_t quickCount;
+    std::size_t count;
+};
+
+const Case cases[] {
+    { "content-length",            { .bodySize = BODY_SIZE }, true, 3, 50 },
+    { "1 byte sends, coalesced",  { .bodySize = BODY_SIZE, .segmentSize = 1 }, true, 3, 50 },
+    { "chunked, 16 byte chunks",   { .bodySize = BODY_SIZE, .framing = MockScript::Framing::Chunked, .chunkSize = 16 }, true, 3, 50 },
+    { "chunked, 1 byte chunks",    { .bodySize = BODY_SIZE, .framing = MockScript::Framing::Chunked, .chunkSize = 1 }, true, 3, 50 },
+    { "until close",               { .bodySize = BODY_SIZE, .framing = MockScript::Framing::UntilClose }, true, 3, 50 },
+    { "drip 8 KiB/s, 64 byte",     { .bodySize = 2048, .segmentSize = 64, .bytesPerSecond = 8192 }, true, 2, 10 },
+    { "length lie, 64 KiB",        { .bodySize = BODY_SIZE, .declaredLength = 64 * 1024 }, false, 3, 50 },
+    { "length lie, 1 GiB",         { .bodySize = BODY_SIZE, .declaredLength = std::size_t{1} << 30 }, false, 3, 50 },
+    { "reset after 8 KiB",         { .bodySize = BODY_SIZE, .resetAfter = 8 * 1024 }, false, 3, 50 },
+};
+
+//! "ok" or the error of the request without the common prefix and details
+std::string outcome(const AsyncHttpRequest &request)
+{
+    const auto result = request.result();
+    if (result)
+        return "ok";
+
+    std::string_view error{result.error()};
+    if (error.starts_with("http request failed: "))
+        error.remove_prefix(21);
+    return std::string{error.substr(0, error.find(" ("))};
+}
+//! Every failing request is logged as a warning by the client and the request, silenced while it lives
+class QuietFailures
+{
+public:
+    explicit QuietFailures(bool active) : m_active{active}
+    {
+        if (m_active)
+            setLevel(ESP_LOG_ERROR);
+    }
+    ~QuietFailures()
+    {
+        if (m_active)
+            setLevel(ESP_LOG_WARN);
+    }
+
+private:
+    static void setLevel(esp_log_level_t level)
+    {
+        esp_log_level_set("ASYNC_HTTP", level);
+        esp_log_level_set("HTTP_CLIENT", level);
+    }
+
+    bool m_active;
+};
+} // namespace
+
+Result runPathologies(const Options &options)
+{
+    std::printf("pathologies: a polled AsyncHttpRequest against scripted misbehaving servers, size limit %zu KiB\n"
+                "cpu is the polling thread per request (perform() and httpEventHandler()), per byte of body the server sent,\n"
+                "body stats and buffer of the last response, the buffer is taken after every request so each response grows it anew,\n"
+                "1 byte sends leave the server one by one but loopback coalesces them while the client waits for the next poll,\n"
+                "peak is the highest heap usage above the idle request\n\n",
+                SIZE_LIMIT / 1024);
+
+    Table table{{"server", "result", "requests", "cpu us", "cpu ns/byte", "data events", "chunks", "growths", "buffer KiB", "peak KiB"}};
+
+    for (const auto &testCase : cases)
+    {
+        MockServer server{testCase.script};
+
+        AsyncHttpRequest asyncRequest{AsyncHttpRequest::Polled{}, "benchPathologies"};
+        asyncRequest.setSizeLimit(SIZE_LIMIT);
+
+        const auto url = server.url();
+        const auto expected = LoopbackServer::pattern(testCase.script.bodySize);
+        const std::size_t count = options.quick ? testCase.quickCount : testCase.count;
+        const QuietFailures quiet{!testCase.succeeds};
+
+        std::vector<std::chrono::nanoseconds> cpuTimes;
+        cpuTimes.reserve(count);
+        std::size_t peak{};
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            // otherwise the buffer keeps its capacity and only the first response would grow it
+            AsyncHttpString{asyncRequest.takeBuffer()};
+
+            const auto baseline = AllocationCounter::currentBytes();
+            AllocationCounter::resetPeak();
+            const auto cpuBefore = threadCpuTime();
+
+            if (auto result = asyncRequest.start(url); !result)
+                return { .ok = false, .error = std::string{testCase.name} + ": start() failed: " + result.error() };
+            if (auto result = pollFinished(asyncRequest); !result.ok)
+                return { .ok = false, .error = std::string{testCase.name} + ": " + result.error };
+
+            cpuTimes.push_back(threadCpuTime() - cpuBefore);
+            peak = std::max(peak, AllocationCounter::peakBytes() - std::min(baseline, AllocationCounter::peakBytes()));
+
+            if (bool(asyncRequest.result()) != testCase.succeeds)
+                return { .ok = false, .error = std::string{testCase.name} + ": unexpected outcome " + outcome(asyncRequest) };
+            if (testCase.succeeds && std::string_view{asyncRequest.buffer()} != expected)
+                return { .ok = false, .error = std::string{testCase.name} + ": the body arrived corrupted" };
+        }
+
+        const auto &stats = asyncRequest.bodyStats();
+        const auto cpu = percentile(cpuTimes, .5);
+
+        // per byte of body the server sent, failed requests report no response size
+        const auto sent = std::min(testCase.script.bodySize, testCase.script.resetAfter.value_or(testCase.script.bodySize));
+        char perByte[32];
+        std::snprintf(perByte, sizeof(perByte), "%.1f", double(cpu.count()) / std::max<std::size_t>(sent, 1));
+
+        table.row({
+            testCase.name, outcome(asyncRequest), std::to_string(count), std::to_string(cpu.count() / 1000), perByte,
+            std::to_string(stats.dataEvents),
+            std::to_string(stats.smallestChunk) + ".." + std::to_string(stats.largestChunk),
+            std::to_string(stats.bufferGrowths), kib(asyncRequest.buffer().capacity()), kib(peak),
+        });
+    }
+
+    table.print();
+
+    return {};
+}
+} // namespace bench
@@ -0,0 +1,156 @@
+// system includes
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// esp-idf includes
+#include <esp_log.h>
+
+// local includes
+#include "asynchttprequest.h"
+#include "asynchttpworker.h"
+#include "benchmark.h"
+#include "loopbackserver.h"
+
+using namespace std::chrono_literals;
+
+namespace bench {
+namespace {
+constexpr std::size_t BULK_REQUESTS = 4;
+constexpr std::size_t INTERACTIVE_SIZE = 512;
+// the bulk downloads are aborted long before they could finish
+constexpr std::size_t BULK_SIZE = std::size_t{1} << 40;
+// about 1 MiB/s per download, like a wifi link shared with other traffic, unthrottled loopback
+// would let a single perform() read for as long as the server keeps up
+constexpr std::size_t BULK_PIECE = 8 * 1024;
+constexpr auto BULK_PIECE_INTERVAL = 8ms;
+// the sink stands in for writing to flash at about 6 MiB/s, the downloads keep the worker task busy two thirds of the time
+constexpr auto SINK_COST_PER_BYTE = 150ns;
+
+//! GET /bulk streams BULK_SIZE bytes at the throttled rate, anything else is served as usual
+bool bulkHandler(const LoopbackServer::Request &request, LoopbackServer::Connection &connection)
+{
+    if (request.target != "/bulk")
+        return LoopbackServer::respondBytes(request, connection, INTERACTIVE_SIZE);
+
+    char head[128];
+    const auto length = std::snprintf(head, sizeof(head), "HTTP/1.1 200 OK\r\nContent-Length: %zu\r\n\r\n", BULK_SIZE);
+    if (!connection.send({head, std::size_t(length)}))
+        return false;
+
+    const auto piece = LoopbackServer::pattern(BULK_PIECE);
+    auto next = Clock::now();
+    while (connection.send(piece))
+    {
+        next += BULK_PIECE_INTERVAL;
+        std::this_thread::sleep_until(next);
+    }
+
+    return false;
+}
+
+struct Scenario
+{
+    const char *name;
+    AsyncHttpRequest::Priority interactive;
+    AsyncHttpRequest::Priority bulk;
+    bool pauseBulk;
+};
+
+constexpr Scenario scenarios[] {
+    { "same priority",         AsyncHttpRequest::Priority::Normal,      AsyncHttpRequest::Priority::Normal, false },
+    { "interactive over bulk", AsyncHttpRequest::Priority::Interactive, AsyncHttpRequest::Priority::Bulk,   false },
+    { "bulk paused",           AsyncHttpRequest::Priority::Interactive, AsyncHttpRequest::Priority::Bulk,   true },
+};
+} // namespace
+
+Result runPriority(const Options &options)
+{
+    std::printf("priority: one AsyncHttpWorker task drives %zu endless bulk downloads (%zu KiB every %lli ms each) into a body\n"
+                "sink which spins %lli ns per byte and an interactive %zu byte GET issued every 10ms, latency is start() to waitFinished() of the interactive one\n\n",
+                BULK_REQUESTS, BULK_PIECE / 1024, (long long)BULK_PIECE_INTERVAL.count(), (long long)SINK_COST_PER_BYTE.count(), INTERACTIVE_SIZE);
+
+    LoopbackServer server{bulkHandler};
+
+    Table table{{"scenario", "requests", "p50 ms", "p90 ms", "p99 ms", "bulk MiB/s"}};
+
+    for (const auto &scenario : scenarios)
+    {
+        AsyncHttpWorker worker{"benchWorker"};
+
+        std::atomic<std::size_t> bulkBytes{};
+        std::array<std::unique_ptr<AsyncHttpRequest>, BULK_REQUESTS> bulkRequests;
+
+        for (auto &bulkRequest : bulkRequests)
+        {
+            bulkRequest = std::make_unique<AsyncHttpRequest>(worker, "benchBulk");
+            bulkRequest->setPriority(scenario.bulk);
+            bulkRequest->setPauseForInteractive(scenario.pauseBulk);
+            bulkRequest->setBodySink([&](std::span<const std::byte> chunk){
+                const auto until = Clock::now() + chunk.size() * SINK_COST_PER_BYTE;
+                while (Clock::now() < until);
+                bulkBytes += chunk.size();
+                return ESP_OK;
+            });
+
+            if (auto result = bulkRequest->start(server.url("/bulk")); !result)
+                return { .ok = false, .error = "starting a bulk download failed: " + result.error() };
+        }
+
+        AsyncHttpRequest interactive{worker, "benchInteractive"};
+        interactive.setPriority(scenario.interactive);
+
+        const auto url = server.url("/bytes/" + std::to_string(INTERACTIVE_SIZE));
+
+        // connects while the bulk downloads get going
+        if (auto result = fetch(interactive, url, INTERACTIVE_SIZE); !result.ok)
+            return result;
+
+        const std::size_t count = options.quick ? 10 : 200;
+        std::vector<Clock::duration> latencies;
+        latencies.reserve(count);
+
+        const auto bulkBytesBefore = bulkBytes.load();
+        const auto begin = Clock::now();
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            std::this_thread::sleep_for(10ms);
+
+            const auto started = Clock::now();
+            if (auto result = fetch(interactive, url, INTERACTIVE_SIZE); !result.ok)
+                return { .ok = false, .error = std::string{scenario.name} + ": " + result.error };
+            latencies.push_back(Clock::now() - started);
+        }
+
+        const auto elapsed = std::chrono::duration<double>{Clock::now() - begin}.count();
+        const auto bulkRate = (bulkBytes - bulkBytesBefore) / elapsed / (1024 * 1024);
+
+        // every abort is logged as a warning
+        esp_log_level_set("ASYNC_HTTP", ESP_LOG_ERROR);
+        for (auto &bulkRequest : bulkRequests)
+        {
+            if (auto result = bulkRequest->abort(); !result)
+                return { .ok = false, .error = "aborting a bulk download failed: " + result.error() };
+            if (!bulkRequest->waitFinished(10s))
+                return { .ok = false, .error = "an aborted bulk download did not finish within 10s" };
+        }
+        esp_log_level_set("ASYNC_HTTP", ESP_LOG_WARN);
+
+        char rate[32];
+        std::snprintf(rate, sizeof(rate), "%.0f", bulkRate);
+
+        table.row({ scenario.name, std::to_string(count),
+                    ms(percentile(latencies, .5)), ms(percentile(latencies, .9)), ms(percentile(latencies, .99)), rate });
+    }
+
+    table.print();
+
+    return {};
+}
+} // namespace bench
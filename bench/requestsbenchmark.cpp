@@ -0,0 +1,77 @@
+// system includes
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// local includes
+#include "asynchttprequest.h"
+#include "allocationcounter.h"
+#include "benchmark.h"
+#include "loopbackserver.h"
+
+using namespace std::chrono_literals;
+
+namespace bench {
+Result runRequests(const Options &options)
+{
+    std::printf("requests: one AsyncHttpRequest with its own task, start() and waitFinished() in a loop\n\n");
+
+    LoopbackServer server;
+
+    Table table{{"body", "keep-alive", "requests", "req/s", "p50 ms", "p90 ms", "p99 ms", "allocs/req", "bytes/req", "peak KiB", "connections"}};
+
+    for (const std::size_t size : {std::size_t{0}, std::size_t{1024}, std::size_t{16 * 1024}, std::size_t{256 * 1024}})
+        for (const bool keepAlive : {true, false})
+        {
+            AsyncHttpRequest asyncRequest{"benchRequest"};
+            asyncRequest.setKeepAlive(keepAlive);
+            asyncRequest.setSizeLimit(std::max<std::size_t>(size, 1));
+
+            const auto url = server.url("/bytes/" + std::to_string(size));
+
+            // creates the task and the client
+            if (auto result = fetch(asyncRequest, url, size); !result.ok)
+                return result;
+
+            const std::size_t count = options.quick ? 10 : (size > 16 * 1024 ? 200 : 1000);
+            std::vector<Clock::duration> latencies;
+            latencies.reserve(count);
+
+            const auto connectionsBefore = server.connections();
+            const auto baseline = AllocationCounter::currentBytes();
+            AllocationCounter::resetPeak();
+            const AllocationScope allocations;
+            const auto begin = Clock::now();
+
+            for (std::size_t i = 0; i < count; i++)
+            {
+                const auto started = Clock::now();
+                if (auto result = fetch(asyncRequest, url, size); !result.ok)
+                    return result;
+                latencies.push_back(Clock::now() - started);
+            }
+
+            const auto elapsed = Clock::now() - begin;
+            const auto allocationCount = allocations.allocations();
+            const auto allocationBytes = allocations.bytes();
+            const auto peak = AllocationCounter::peakBytes() - baseline;
+
+            char rps[32];
+            std::snprintf(rps, sizeof(rps), "%.0f", count / std::chrono::duration<double>{elapsed}.count());
+            char allocsPerRequest[32];
+            std::snprintf(allocsPerRequest, sizeof(allocsPerRequest), "%.1f", double(allocationCount) / count);
+
+            table.row({
+                kib(size) + " KiB", keepAlive ? "on" : "off", std::to_string(count), rps,
+                ms(percentile(latencies, .5)), ms(percentile(latencies, .9)), ms(percentile(latencies, .99)),
+                allocsPerRequest, std::to_string(allocationBytes / count), kib(peak),
+                std::to_string(server.connections() - connectionsBefore),
+            });
+        }
+
+    table.print();
+
+    return {};
+}
+} // namespace bench
@@ -0,0 +1,32 @@
+#pragma once
+
+// stand-in for cpputils' cleanuphelper.h
+
+// system includes
+#include <optional>
+#include <utility>
+
+namespace cpputils {
+template<typename T>
+class CleanupHelper
+{
+public:
+    explicit CleanupHelper(T &&callback) : m_callback{std::move(callback)} {}
+    CleanupHelper(const CleanupHelper &) = delete;
+    CleanupHelper(CleanupHelper &&other) : m_callback{std::move(other.m_callback)} { other.m_callback = std::nullopt; }
+    ~CleanupHelper() { if (m_callback) (*m_callback)(); }
+
+    CleanupHelper &operator=(const CleanupHelper &) = delete;
+
+    void disarm() { m_callback = std::nullopt; }
+
+private:
+    std::optional<T> m_callback;
+};
+
+template<typename T>
+CleanupHelper<T> makeCleanupHelper(T &&callback)
+{
+    return CleanupHelper<T>{std::move(callback)};
+}
+} // namespace cpputils
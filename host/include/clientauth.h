@@ -0,0 +1,14 @@
+#pragma once
+
+// stand-in for cpputils' clientauth.h
+
+// system includes
+#include <string_view>
+
+namespace cpputils {
+struct ClientAuth
+{
+    std::string_view clientKey;
+    std::string_view clientCert;
+};
+} // namespace cpputils
@@ -0,0 +1,14 @@
+#pragma once
+
+// stand-in for cpputils.h, only the helpers the component uses
+
+// system includes
+#include <utility>
+
+namespace cpputils {
+template<typename T, typename ...Ts>
+constexpr bool is_in(T &&val, Ts &&...values)
+{
+    return ((val == values) || ...);
+}
+} // namespace cpputils
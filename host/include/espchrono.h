@@ -0,0 +1,26 @@
+#pragma once
+
+// stand-in for espchrono.h, only the clock the component uses
+
+// system includes
+#include <chrono>
+
+// local includes
+#include "esp_timer.h"
+
+namespace espchrono {
+struct millis_clock
+{
+    using duration = std::chrono::milliseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<millis_clock, duration>;
+
+    static constexpr bool is_steady = true;
+
+    static time_point now() noexcept
+    {
+        return time_point{std::chrono::floor<duration>(std::chrono::microseconds{esp_timer_get_time()})};
+    }
+};
+} // namespace espchrono
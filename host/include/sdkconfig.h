@@ -0,0 +1,58 @@
+#pragma once
+
+// Kconfig values for the host build, every one can be overridden with a compile definition
+
+#define CONFIG_IDF_TARGET_LINUX 1
+
+#ifndef CONFIG_LOG_LOCAL_LEVEL_ASYNC_HTTP
+#define CONFIG_LOG_LOCAL_LEVEL_ASYNC_HTTP 3
+#endif
+
+#ifndef CONFIG_ASYNC_HTTP_TASK_PRIORITY
+#define CONFIG_ASYNC_HTTP_TASK_PRIORITY 10
+#endif
+
+#ifndef CONFIG_ASYNC_HTTP_POLL_INTERVAL_MIN_MS
+#define CONFIG_ASYNC_HTTP_POLL_INTERVAL_MIN_MS 5
+#endif
+
+#ifndef CONFIG_ASYNC_HTTP_POLL_INTERVAL_MAX_MS
+#define CONFIG_ASYNC_HTTP_POLL_INTERVAL_MAX_MS 100
+#endif
+
+#ifndef CONFIG_ASYNC_HTTP_POOL_MAX_PER_ORIGIN
+#define CONFIG_ASYNC_HTTP_POOL_MAX_PER_ORIGIN 2
+#endif
+
+#ifndef CONFIG_ASYNC_HTTP_POOL_MAX_TOTAL
+#define CONFIG_ASYNC_HTTP_POOL_MAX_TOTAL 4
+#endif
+
+#ifndef CONFIG_ASYNC_HTTP_POOL_IDLE_TIMEOUT_MS
+#define CONFIG_ASYNC_HTTP_POOL_IDLE_TIMEOUT_MS 30000
+#endif
+
+#ifndef CONFIG_ASYNC_HTTP_TLS_SESSIONS_PER_ORIGIN
+#define CONFIG_ASYNC_HTTP_TLS_SESSIONS_PER_ORIGIN 1
+#endif
+
+#ifndef CONFIG_ASYNC_HTTP_TLS_SESSION_TIMEOUT_MS
+#define CONFIG_ASYNC_HTTP_TLS_SESSION_TIMEOUT_MS 600000
+#endif
+
+#ifndef CONFIG_ASYNC_HTTP_SEGMENT_SIZE
+#define CONFIG_ASYNC_HTTP_SEGMENT_SIZE 1024
+#endif
+
+#ifndef CONFIG_ASYNC_HTTP_SEGMENT_POOL_SIZE
+#define CONFIG_ASYNC_HTTP_SEGMENT_POOL_SIZE 4
+#endif
+
+#ifndef CONFIG_ASYNC_HTTP_NO_METRICS
+#define CONFIG_ASYNC_HTTP_METRICS 1
+#endif
+
+// esp-tls, the host transport keeps the session of a client when save_client_session is set
+#ifndef CONFIG_ESP_TLS_NO_CLIENT_SESSION_TICKETS
+#define CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS 1
+#endif
@@ -0,0 +1,37 @@
+#pragma once
+
+// stand-in for espcpputils' taskutils.h
+
+// system includes
+#include <chrono>
+
+// local includes
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "tickchrono.h"
+
+namespace espcpputils {
+enum class CoreAffinity
+{
+    Core0,
+    Core1,
+    Both
+};
+
+inline BaseType_t createTask(TaskFunction_t pvTaskCode, const char * const pcName, uint32_t usStackDepth,
+                             void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pvCreatedTask,
+                             CoreAffinity coreAffinity)
+{
+    switch (coreAffinity)
+    {
+    case CoreAffinity::Core0: return xTaskCreatePinnedToCore(pvTaskCode, pcName, usStackDepth, pvParameters, uxPriority, pvCreatedTask, 0);
+    case CoreAffinity::Core1: return xTaskCreatePinnedToCore(pvTaskCode, pcName, usStackDepth, pvParameters, uxPriority, pvCreatedTask, 1);
+    default: return xTaskCreatePinnedToCore(pvTaskCode, pcName, usStackDepth, pvParameters, uxPriority, pvCreatedTask, tskNO_AFFINITY);
+    }
+}
+
+inline void delay(std::chrono::milliseconds ms)
+{
+    vTaskDelay(std::chrono::ceil<ticks>(ms).count());
+}
+} // namespace espcpputils
@@ -0,0 +1,13 @@
+#pragma once
+
+// stand-in for espcpputils' tickchrono.h
+
+// system includes
+#include <chrono>
+
+// local includes
+#include "freertos/FreeRTOS.h"
+
+namespace espcpputils {
+using ticks = std::chrono::duration<TickType_t, std::ratio<1, configTICK_RATE_HZ>>;
+} // namespace espcpputils
@@ -0,0 +1,31 @@
+#pragma once
+
+// stand-in for espcpputils' wrappers/event_group.h
+
+// local includes
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+
+namespace espcpputils {
+class event_group
+{
+public:
+    event_group() : handle{xEventGroupCreate()} {}
+    event_group(const event_group &) = delete;
+    ~event_group() { if (handle) vEventGroupDelete(handle); }
+
+    event_group &operator=(const event_group &) = delete;
+
+    EventBits_t waitBits(const EventBits_t uxBitsToWaitFor, const BaseType_t xClearOnExit,
+                         const BaseType_t xWaitForAllBits, TickType_t xTicksToWait)
+    {
+        return xEventGroupWaitBits(handle, uxBitsToWaitFor, xClearOnExit, xWaitForAllBits, xTicksToWait);
+    }
+
+    EventBits_t setBits(const EventBits_t uxBitsToSet) { return xEventGroupSetBits(handle, uxBitsToSet); }
+    EventBits_t clearBits(const EventBits_t uxBitsToClear) { return xEventGroupClearBits(handle, uxBitsToClear); }
+    EventBits_t getBits() const { return xEventGroupGetBits(handle); }
+
+    const EventGroupHandle_t handle;
+};
+} // namespace espcpputils
@@ -0,0 +1,48 @@
+#pragma once
+
+// stand-in for espcpputils' wrappers/http_client.h
+
+// system includes
+#include <string>
+#include <string_view>
+#include <utility>
+
+// local includes
+#include "esp_http_client.h"
+
+namespace espcpputils {
+class http_client
+{
+public:
+    http_client() = default;
+    http_client(const esp_http_client_config_t *config) : handle{esp_http_client_init(config)} {}
+    http_client(const http_client &) = delete;
+    http_client(http_client &&other) : handle{std::exchange(other.handle, nullptr)} {}
+    ~http_client() { if (handle) esp_http_client_cleanup(handle); }
+
+    http_client &operator=(const http_client &) = delete;
+    http_client &operator=(http_client &&other)
+    {
+        if (handle)
+            esp_http_client_cleanup(handle);
+        handle = std::exchange(other.handle, nullptr);
+        return *this;
+    }
+
+    operator bool() const { return handle != nullptr; }
+
+    esp_err_t perform() { return esp_http_client_perform(handle); }
+    esp_err_t set_url(std::string_view url) { return esp_http_client_set_url(handle, std::string{url}.c_str()); }
+    esp_err_t set_method(esp_http_client_method_t method) { return esp_http_client_set_method(handle, method); }
+    esp_err_t set_header(std::string_view key, std::string_view value) { return esp_http_client_set_header(handle, std::string{key}.c_str(), std::string{value}.c_str()); }
+    esp_err_t delete_header(std::string_view key) { return esp_http_client_delete_header(handle, std::string{key}.c_str()); }
+    esp_err_t set_post_field(std::string_view buf) { return esp_http_client_set_post_field(handle, buf.data(), buf.size()); }
+    esp_err_t set_timeout_ms(int timeout_ms) { return esp_http_client_set_timeout_ms(handle, timeout_ms); }
+    int get_status_code() { return esp_http_client_get_status_code(handle); }
+    int64_t get_content_length() { return esp_http_client_get_content_length(handle); }
+    bool is_chunked_response() { return esp_http_client_is_chunked_response(handle); }
+    esp_err_t close() { return esp_http_client_close(handle); }
+
+    esp_http_client_handle_t handle{};
+};
+} // namespace espcpputils
@@ -0,0 +1,55 @@
+#include "esp_err.h"
+
+// system includes
+#include <iterator>
+
+// local includes
+#include "esp_http_client.h"
+
+namespace {
+struct ErrorName
+{
+    esp_err_t code;
+    const char *name;
+};
+
+#define ERR_NAME(code) ErrorName{ code, #code }
+
+constexpr ErrorName errorNames[] {
+    ERR_NAME(ESP_OK),
+    ERR_NAME(ESP_FAIL),
+    ERR_NAME(ESP_ERR_NO_MEM),
+    ERR_NAME(ESP_ERR_INVALID_ARG),
+    ERR_NAME(ESP_ERR_INVALID_STATE),
+    ERR_NAME(ESP_ERR_INVALID_SIZE),
+    ERR_NAME(ESP_ERR_NOT_FOUND),
+    ERR_NAME(ESP_ERR_NOT_SUPPORTED),
+    ERR_NAME(ESP_ERR_TIMEOUT),
+    ERR_NAME(ESP_ERR_INVALID_RESPONSE),
+    ERR_NAME(ESP_ERR_INVALID_CRC),
+    ERR_NAME(ESP_ERR_INVALID_VERSION),
+    ERR_NAME(ESP_ERR_INVALID_MAC),
+    ERR_NAME(ESP_ERR_NOT_FINISHED),
+    ERR_NAME(ESP_ERR_NOT_ALLOWED),
+    ERR_NAME(ESP_ERR_HTTP_MAX_REDIRECT),
+    ERR_NAME(ESP_ERR_HTTP_CONNECT),
+    ERR_NAME(ESP_ERR_HTTP_WRITE_DATA),
+    ERR_NAME(ESP_ERR_HTTP_FETCH_HEADER),
+    ERR_NAME(ESP_ERR_HTTP_INVALID_TRANSPORT),
+    ERR_NAME(ESP_ERR_HTTP_CONNECTING),
+    ERR_NAME(ESP_ERR_HTTP_EAGAIN),
+    ERR_NAME(ESP_ERR_HTTP_CONNECTION_CLOSED),
+    ERR_NAME(ESP_ERR_HTTP_INCOMPLETE_DATA),
+};
+
+#undef ERR_NAME
+} // namespace
+
+extern "C" const char *esp_err_to_name(esp_err_t code)
+{
+    for (const auto &entry : errorNames)
+        if (entry.code == code)
+            return entry.name;
+
+    return "UNKNOWN ERROR";
+}
@@ -0,0 +1,164 @@
+#include "esp_event.h"
+
+// system includes
+#include <cstring>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+struct esp_event_loop
+{
+    struct Handler
+    {
+        esp_event_base_t base;
+        int32_t id;
+        esp_event_handler_t handler;
+        void *arg;
+    };
+
+    std::mutex mutex;
+    std::vector<Handler> handlers;
+};
+
+namespace {
+std::mutex defaultLoopMutex;
+esp_event_loop *defaultLoop{};
+
+bool matches(esp_event_base_t registered, esp_event_base_t base)
+{
+    return registered == ESP_EVENT_ANY_BASE || registered == base || std::strcmp(registered, base) == 0;
+}
+
+esp_err_t registerHandler(esp_event_loop *loop, esp_event_base_t event_base, int32_t event_id,
+                          esp_event_handler_t event_handler, void *event_handler_arg)
+{
+    if (!loop)
+        return ESP_ERR_INVALID_STATE;
+    if (!event_handler)
+        return ESP_ERR_INVALID_ARG;
+
+    std::lock_guard lock{loop->mutex};
+    loop->handlers.push_back(esp_event_loop::Handler{ .base = event_base, .id = event_id, .handler = event_handler, .arg = event_handler_arg });
+    return ESP_OK;
+}
+
+esp_err_t post(esp_event_loop *loop, esp_event_base_t event_base, int32_t event_id, const void *event_data)
+{
+    if (!loop)
+        return ESP_ERR_INVALID_STATE;
+
+    // a handler may register or unregister handlers itself
+    std::vector<esp_event_loop::Handler> handlers;
+    {
+        std::lock_guard lock{loop->mutex};
+        for (const auto &entry : loop->handlers)
+            if (matches(entry.base, event_base) && (entry.id == ESP_EVENT_ANY_ID || entry.id == event_id))
+                handlers.push_back(entry);
+    }
+
+    for (const auto &entry : handlers)
+        entry.handler(entry.arg, event_base, event_id, const_cast<void *>(event_data));
+
+    return ESP_OK;
+}
+} // namespace
+
+extern "C" {
+
+esp_err_t esp_event_loop_create_default(void)
+{
+    std::lock_guard lock{defaultLoopMutex};
+    if (defaultLoop)
+        return ESP_ERR_INVALID_STATE;
+
+    defaultLoop = new esp_event_loop;
+    return ESP_OK;
+}
+
+esp_err_t esp_event_loop_delete_default(void)
+{
+    std::lock_guard lock{defaultLoopMutex};
+    if (!defaultLoop)
+        return ESP_ERR_INVALID_STATE;
+
+    delete defaultLoop;
+    defaultLoop = nullptr;
+    return ESP_OK;
+}
+
+esp_err_t esp_event_loop_create(const esp_event_loop_args_t *event_loop_args, esp_event_loop_handle_t *event_loop)
+{
+    if (!event_loop_args || !event_loop)
+        return ESP_ERR_INVALID_ARG;
+
+    *event_loop = new esp_event_loop;
+    return ESP_OK;
+}
+
+esp_err_t esp_event_loop_delete(esp_event_loop_handle_t event_loop)
+{
+    if (!event_loop)
+        return ESP_ERR_INVALID_ARG;
+
+    delete event_loop;
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_register(esp_event_base_t event_base, int32_t event_id,
+                                     esp_event_handler_t event_handler, void *event_handler_arg)
+{
+    std::lock_guard lock{defaultLoopMutex};
+    return registerHandler(defaultLoop, event_base, event_id, event_handler, event_handler_arg);
+}
+
+esp_err_t esp_event_handler_register_with(esp_event_loop_handle_t event_loop, esp_event_base_t event_base, int32_t event_id,
+                                          esp_event_handler_t event_handler, void *event_handler_arg)
+{
+    if (!event_loop)
+        return ESP_ERR_INVALID_ARG;
+
+    return registerHandler(event_loop, event_base, event_id, event_handler, event_handler_arg);
+}
+
+esp_err_t esp_event_handler_unregister(esp_event_base_t event_base, int32_t event_id,
+                                       esp_event_handler_t event_handler)
+{
+    std::lock_guard lock{defaultLoopMutex};
+    if (!defaultLoop)
+        return ESP_ERR_INVALID_STATE;
+
+    std::lock_guard loopLock{defaultLoop->mutex};
+    std::erase_if(defaultLoop->handlers, [&](const auto &entry){
+        return entry.base == event_base && entry.id == event_id && entry.handler == event_handler;
+    });
+    return ESP_OK;
+}
+
+esp_err_t esp_event_post(esp_event_base_t event_base, int32_t event_id,
+                         const void *event_data, size_t event_data_size, TickType_t ticks_to_wait)
+{
+    (void)event_data_size;
+    (void)ticks_to_wait;
+
+    esp_event_loop *loop;
+    {
+        std::lock_guard lock{defaultLoopMutex};
+        loop = defaultLoop;
+    }
+
+    return post(loop, event_base, event_id, event_data);
+}
+
+esp_err_t esp_event_post_to(esp_event_loop_handle_t event_loop, esp_event_base_t event_base, int32_t event_id,
+                            const void *event_data, size_t event_data_size, TickType_t ticks_to_wait)
+{
+    (void)event_data_size;
+    (void)ticks_to_wait;
+
+    if (!event_loop)
+        return ESP_ERR_INVALID_ARG;
+
+    return post(event_loop, event_base, event_id, event_data);
+}
+
+} // extern "C"
@@ -0,0 +1,930 @@
+#include "esp_http_client.h"
+
+// system includes
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <poll.h>
+#include <strings.h>
+
+// local includes
+#include "esp_log.h"
+#include "transport.h"
+
+namespace {
+constexpr const char * const TAG = "HTTP_CLIENT";
+
+constexpr int DEFAULT_TIMEOUT_MS = 5000;
+constexpr int DEFAULT_BUFFER_SIZE = 512;
+constexpr std::size_t MAX_LINE_LENGTH = 8192;
+constexpr const char * const DEFAULT_USER_AGENT = "ESP32 HTTP Client/1.0";
+
+constexpr const char *methodNames[] {
+    "GET", "POST", "PUT", "PATCH", "DELETE", "HEAD", "NOTIFY", "SUBSCRIBE", "UNSUBSCRIBE",
+    "OPTIONS", "COPY", "MOVE", "LOCK", "UNLOCK", "PROPFIND", "PROPPATCH", "MKCOL",
+};
+static_assert(std::size(methodNames) == HTTP_METHOD_MAX);
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b)
+{
+    return a.size() == b.size() && strncasecmp(a.data(), b.data(), a.size()) == 0;
+}
+
+bool containsToken(std::string_view list, std::string_view token)
+{
+    while (!list.empty())
+    {
+        auto element = list.substr(0, list.find(','));
+        list.remove_prefix(std::min(element.size() + 1, list.size()));
+
+        while (!element.empty() && element.front() == ' ')
+            element.remove_prefix(1);
+        while (!element.empty() && element.back() == ' ')
+            element.remove_suffix(1);
+
+        if (equalsIgnoreCase(element, token))
+            return true;
+    }
+
+    return false;
+}
+
+void appendNumber(std::string &str, int64_t value)
+{
+    char buf[24];
+    const auto result = std::to_chars(std::begin(buf), std::end(buf), value);
+    str.append(buf, result.ptr);
+}
+
+struct Url
+{
+    std::string_view scheme;
+    std::string_view host;
+    int port{};
+    std::string_view target;
+};
+
+bool parseUrl(std::string_view url, Url &result)
+{
+    const auto schemeEnd = url.find("://");
+    if (schemeEnd == std::string_view::npos)
+        return false;
+
+    result.scheme = url.substr(0, schemeEnd);
+    url.remove_prefix(schemeEnd + 3);
+
+    const auto authorityEnd = url.find_first_of("/?#");
+    auto authority = url.substr(0, authorityEnd);
+    url.remove_prefix(authority.size());
+
+    if (const auto userInfoEnd = authority.rfind('@'); userInfoEnd != std::string_view::npos)
+        authority.remove_prefix(userInfoEnd + 1);
+
+    if (equalsIgnoreCase(result.scheme, "http"))
+        result.port = 80;
+    else if (equalsIgnoreCase(result.scheme, "https"))
+        result.port = 443;
+    else
+        return false;
+
+    if (!authority.empty() && authority.front() == '[')
+    {
+        const auto end = authority.find(']');
+        if (end == std::string_view::npos)
+            return false;
+        result.host = authority.substr(1, end - 1);
+        authority.remove_prefix(end + 1);
+    }
+    else
+    {
+        result.host = authority.substr(0, authority.find(':'));
+        authority.remove_prefix(result.host.size());
+    }
+
+    if (!authority.empty())
+    {
+        if (authority.front() != ':')
+            return false;
+        authority.remove_prefix(1);
+        if (std::from_chars(authority.data(), authority.data() + authority.size(), result.port).ec != std::errc{})
+            return false;
+    }
+
+    if (result.host.empty())
+        return false;
+
+    result.target = url.substr(0, url.find('#'));
+    return true;
+}
+
+struct Header
+{
+    std::string key;
+    std::string value;
+};
+} // namespace
+
+struct esp_http_client
+{
+    enum class State
+    {
+        Closed,
+        Connecting,
+        Connected,
+        SendHead,
+        SendBody,
+        ReadHead,
+        ReadBody,
+    };
+
+    enum class Body
+    {
+        None,
+        Length,
+        Chunked,
+        UntilClose,
+    };
+
+    enum class Chunk
+    {
+        Size,
+        Data,
+        DataEnd,
+        Trailer,
+    };
+
+    enum class Fill
+    {
+        Ok,
+        WouldBlock,
+        Eof,
+        Error,
+    };
+
+    esp_err_t init(const esp_http_client_config_t &config);
+    esp_err_t setUrl(std::string_view url);
+    void setHeader(std::string_view key, std::string_view value);
+    esp_err_t perform();
+    esp_err_t close();
+
+    esp_err_t step();
+    esp_err_t blocked();
+    esp_err_t fail(esp_err_t result, esp_http_client_event_id_t event = HTTP_EVENT_ERROR);
+    esp_err_t finish();
+    void buildRequest();
+    bool takeLine();
+    Fill fill();
+    bool parseStatusLine();
+    void parseHeaderLine();
+    esp_err_t readBody();
+    void dispatch(esp_http_client_event_id_t id, void *data = nullptr, int dataLen = 0,
+                  char *headerKey = nullptr, char *headerValue = nullptr);
+    void touch() { m_lastProgress = std::chrono::steady_clock::now(); }
+
+    // configuration
+    std::string m_scheme;
+    std::string m_host;
+    int m_port{};
+    std::string m_target;
+    std::vector<Header> m_headers;
+    esp_http_client_method_t m_method{HTTP_METHOD_GET};
+    int m_timeoutMs{DEFAULT_TIMEOUT_MS};
+    http_event_handle_cb m_eventHandler{};
+    void *m_userData{};
+    bool m_async{};
+    const char *m_postData{};
+    int m_postLen{};
+    TlsConfig m_tls;
+
+    // connection
+    std::unique_ptr<Transport> m_transport;
+    State m_state{State::Closed};
+    std::chrono::steady_clock::time_point m_lastProgress;
+
+    // request, kept around so a steady state request does not allocate
+    std::string m_request;
+    std::size_t m_sent{};
+
+    // response
+    std::unique_ptr<char[]> m_rx;
+    std::size_t m_rxSize{};
+    std::size_t m_rxBegin{};
+    std::size_t m_rxEnd{};
+    std::string m_line;
+    bool m_statusReceived{};
+    int m_statusCode{};
+    bool m_http10{};
+    bool m_keepAlive{};
+    int64_t m_contentLength{-1};
+    bool m_chunked{};
+    Body m_body{};
+    Chunk m_chunk{};
+    int64_t m_remaining{};
+};
+
+esp_err_t esp_http_client::init(const esp_http_client_config_t &config)
+{
+    m_rxSize = config.buffer_size > 0 ? config.buffer_size : DEFAULT_BUFFER_SIZE;
+    m_rx = std::make_unique<char[]>(m_rxSize);
+    m_line.reserve(256);
+    m_request.reserve(512);
+
+    m_method = config.method;
+    m_timeoutMs = config.timeout_ms > 0 ? config.timeout_ms : DEFAULT_TIMEOUT_MS;
+    m_eventHandler = config.event_handler;
+    m_userData = config.user_data;
+    m_async = config.is_async;
+
+    // only the pointers are kept like in esp_http_client, the buffers have to outlive the client
+    if (config.cert_pem)
+        m_tls.serverCert = {config.cert_pem, config.cert_len ? config.cert_len : std::strlen(config.cert_pem)};
+    if (config.client_cert_pem)
+        m_tls.clientCert = {config.client_cert_pem, config.client_cert_len ? config.client_cert_len : std::strlen(config.client_cert_pem)};
+    if (config.client_key_pem)
+        m_tls.clientKey = {config.client_key_pem, config.client_key_len ? config.client_key_len : std::strlen(config.client_key_pem)};
+    if (config.common_name)
+        m_tls.commonName = config.common_name;
+    m_tls.skipCommonNameCheck = config.skip_cert_common_name_check;
+    m_tls.saveSession = config.save_client_session;
+
+    setHeader("User-Agent", config.user_agent ? config.user_agent : DEFAULT_USER_AGENT);
+
+    if (!config.url)
+    {
+        ESP_LOGE(TAG, "only configurations with an url are supported");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return setUrl(config.url);
+}
+
+esp_err_t esp_http_client::setUrl(std::string_view url)
+{
+    Url parsed;
+
+    if (!url.empty() && url.front() == '/')
+    {
+        m_target = url;
+        return ESP_OK;
+    }
+
+    if (!parseUrl(url, parsed))
+    {
+        ESP_LOGE(TAG, "could not parse url %.*s", int(url.size()), url.data());
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!equalsIgnoreCase(parsed.scheme, m_scheme) || parsed.host != m_host || parsed.port != m_port)
+    {
+        close();
+        m_transport = nullptr;
+        m_scheme = parsed.scheme;
+        m_host = parsed.host;
+        m_port = parsed.port;
+
+        std::string host{m_host};
+        if (m_port != (equalsIgnoreCase(m_scheme, "https") ? 443 : 80))
+        {
+            host += ':';
+            appendNumber(host, m_port);
+        }
+        setHeader("Host", host);
+    }
+
+    if (parsed.target.empty())
+        m_target = "/";
+    else if (parsed.target.front() == '?')
+        (m_target = "/") += parsed.target;
+    else
+        m_target = parsed.target;
+
+    return ESP_OK;
+}
+
+void esp_http_client::setHeader(std::string_view key, std::string_view value)
+{
+    for (auto &header : m_headers)
+        if (equalsIgnoreCase(header.key, key))
+        {
+            header.value = value;
+            return;
+        }
+
+    m_headers.push_back(Header{ .key = std::string{key}, .value = std::string{value} });
+}
+
+esp_err_t esp_http_client::perform()
+{
+    while (true)
+    {
+        const auto result = step();
+        if (result != ESP_ERR_HTTP_EAGAIN || m_async)
+            return result;
+
+        // blocking mode, wait for the socket instead of returning
+        const auto elapsed = std::chrono::steady_clock::now() - m_lastProgress;
+        const auto remaining = std::chrono::milliseconds{m_timeoutMs} - std::chrono::duration_cast<std::chrono::milliseconds>(elapsed);
+        const bool writing = m_state == State::SendHead || m_state == State::SendBody || m_transport->wantsWrite();
+        pollfd pfd{ .fd = m_transport->fd(), .events = short(writing ? POLLOUT : POLLIN), .revents = 0 };
+        ::poll(&pfd, 1, std::max<int>(remaining.count(), 0) + 1);
+    }
+}
+
+esp_err_t esp_http_client::step()
+{
+    switch (m_state)
+    {
+    case State::Closed:
+        if (!m_transport)
+        {
+            if (equalsIgnoreCase(m_scheme, "http"))
+                m_transport = makeTcpTransport();
+            else if (equalsIgnoreCase(m_scheme, "https"))
+                m_transport = makeTlsTransport(m_tls);
+            else
+            {
+                ESP_LOGE(TAG, "no transport for scheme %s", m_scheme.c_str());
+                return fail(ESP_ERR_HTTP_INVALID_TRANSPORT);
+            }
+        }
+
+        touch();
+        m_state = State::Connecting;
+        [[fallthrough]];
+    case State::Connecting:
+        if (const auto result = m_transport->connect(m_host, m_port); result < 0)
+        {
+            ESP_LOGE(TAG, "connecting to %s:%i failed: %s", m_host.c_str(), m_port, std::strerror(errno));
+            return fail(ESP_ERR_HTTP_CONNECT);
+        }
+        else if (result == 0)
+            return blocked();
+
+        touch();
+        m_state = State::Connected;
+        dispatch(HTTP_EVENT_ON_CONNECTED);
+        [[fallthrough]];
+    case State::Connected:
+        touch();
+        buildRequest();
+        m_sent = 0;
+        m_state = State::SendHead;
+        [[fallthrough]];
+    case State::SendHead:
+        while (m_sent < m_request.size())
+        {
+            const auto result = m_transport->write(m_request.data() + m_sent, m_request.size() - m_sent);
+            if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                return blocked();
+            else if (result <= 0)
+            {
+                ESP_LOGW(TAG, "writing the request failed: %s", std::strerror(errno));
+                return fail(ESP_ERR_HTTP_WRITE_DATA);
+            }
+
+            m_sent += result;
+            touch();
+        }
+
+        dispatch(HTTP_EVENT_HEADERS_SENT);
+        m_sent = 0;
+        m_state = State::SendBody;
+        [[fallthrough]];
+    case State::SendBody:
+        while (m_sent < std::size_t(m_postLen))
+        {
+            const auto result = m_transport->write(m_postData + m_sent, m_postLen - m_sent);
+            if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                return blocked();
+            else if (result <= 0)
+            {
+                ESP_LOGW(TAG, "writing the request body failed: %s", std::strerror(errno));
+                return fail(ESP_ERR_HTTP_WRITE_DATA);
+            }
+
+            m_sent += result;
+            touch();
+        }
+
+        m_line.clear();
+        m_statusReceived = false;
+        m_statusCode = 0;
+        m_contentLength = -1;
+        m_chunked = false;
+        m_keepAlive = true;
+        m_state = State::ReadHead;
+        [[fallthrough]];
+    case State::ReadHead:
+        while (true)
+        {
+            if (!takeLine())
+            {
+                if (m_line.size() > MAX_LINE_LENGTH)
+                {
+                    ESP_LOGE(TAG, "response header line too long");
+                    return fail(ESP_ERR_HTTP_FETCH_HEADER);
+                }
+
+                switch (fill())
+                {
+                case Fill::Ok: continue;
+                case Fill::WouldBlock: return blocked();
+                case Fill::Eof:
+                    ESP_LOGD(TAG, "connection closed before the response headers");
+                    return fail(ESP_ERR_HTTP_FETCH_HEADER);
+                case Fill::Error:
+                    ESP_LOGW(TAG, "reading the response headers failed: %s", std::strerror(errno));
+                    return fail(ESP_ERR_HTTP_FETCH_HEADER);
+                }
+            }
+
+            if (!m_statusReceived)
+            {
+                if (!parseStatusLine())
+                {
+                    ESP_LOGE(TAG, "invalid status line");
+                    return fail(ESP_ERR_HTTP_FETCH_HEADER);
+                }
+                continue;
+            }
+
+            if (!m_line.empty())
+            {
+                parseHeaderLine();
+                continue;
+            }
+
+            // interim responses are followed by the real one
+            if (m_statusCode >= 100 && m_statusCode < 200)
+            {
+                m_statusReceived = false;
+                continue;
+            }
+
+            break;
+        }
+
+        if (m_method == HTTP_METHOD_HEAD || m_statusCode == 204 || m_statusCode == 304)
+            m_body = Body::None;
+        else if (m_chunked)
+        {
+            m_body = Body::Chunked;
+            m_chunk = Chunk::Size;
+        }
+        else if (m_contentLength >= 0)
+        {
+            m_body = m_contentLength ? Body::Length : Body::None;
+            m_remaining = m_contentLength;
+        }
+        else
+        {
+            m_body = Body::UntilClose;
+            m_keepAlive = false;
+        }
+
+        m_state = State::ReadBody;
+        [[fallthrough]];
+    case State::ReadBody:
+        return readBody();
+    }
+
+    return ESP_FAIL;
+}
+
+esp_err_t esp_http_client::readBody()
+{
+    while (m_body != Body::None)
+    {
+        if (m_body == Body::Chunked && m_chunk != Chunk::Data)
+        {
+            if (!takeLine())
+            {
+                if (m_line.size() > MAX_LINE_LENGTH)
+                    return fail(ESP_ERR_HTTP_INCOMPLETE_DATA);
+
+                switch (fill())
+                {
+                case Fill::Ok: continue;
+                case Fill::WouldBlock: return blocked();
+                case Fill::Eof:
+                case Fill::Error:
+                    ESP_LOGW(TAG, "chunked response body ended early");
+                    return fail(ESP_ERR_HTTP_INCOMPLETE_DATA);
+                }
+            }
+
+            switch (m_chunk)
+            {
+            case Chunk::Size:
+            {
+                const auto size = std::string_view{m_line}.substr(0, m_line.find(';'));
+                uint64_t chunkSize{};
+                if (std::from_chars(size.data(), size.data() + size.size(), chunkSize, 16).ec != std::errc{})
+                {
+                    ESP_LOGE(TAG, "invalid chunk size");
+                    return fail(ESP_ERR_HTTP_INCOMPLETE_DATA);
+                }
+                m_remaining = chunkSize;
+                m_chunk = chunkSize ? Chunk::Data : Chunk::Trailer;
+                break;
+            }
+            case Chunk::DataEnd:
+                m_chunk = Chunk::Size;
+                break;
+            case Chunk::Trailer:
+                if (m_line.empty())
+                    m_body = Body::None;
+                break;
+            default:;
+            }
+            m_line.clear();
+            continue;
+        }
+
+        if (m_rxBegin == m_rxEnd)
+            switch (fill())
+            {
+            case Fill::Ok: break;
+            case Fill::WouldBlock: return blocked();
+            case Fill::Eof:
+                if (m_body == Body::UntilClose)
+                {
+                    m_body = Body::None;
+                    continue;
+                }
+                [[fallthrough]];
+            case Fill::Error:
+                ESP_LOGW(TAG, "response body ended early (%s)", errno ? std::strerror(errno) : "eof");
+                return fail(ESP_ERR_HTTP_INCOMPLETE_DATA);
+            }
+
+        auto size = m_rxEnd - m_rxBegin;
+        if (m_body != Body::UntilClose)
+            size = std::min<std::size_t>(size, m_remaining);
+
+        auto * const data = m_rx.get() + m_rxBegin;
+        m_rxBegin += size;
+        m_remaining -= size;
+
+        dispatch(HTTP_EVENT_ON_DATA, data, int(size));
+
+        if (m_body == Body::Length && !m_remaining)
+            m_body = Body::None;
+        else if (m_body == Body::Chunked && !m_remaining)
+            m_chunk = Chunk::DataEnd;
+    }
+
+    return finish();
+}
+
+esp_err_t esp_http_client::finish()
+{
+    dispatch(HTTP_EVENT_ON_FINISH);
+
+    // bytes the server sent after the response belong to no request
+    if (!m_keepAlive || m_rxBegin != m_rxEnd)
+        close();
+    else
+        m_state = State::Connected;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client::blocked()
+{
+    if (std::chrono::steady_clock::now() - m_lastProgress < std::chrono::milliseconds{m_timeoutMs})
+        return ESP_ERR_HTTP_EAGAIN;
+
+    ESP_LOGW(TAG, "no progress for %i ms", m_timeoutMs);
+    return fail(ESP_ERR_TIMEOUT);
+}
+
+esp_err_t esp_http_client::fail(esp_err_t result, esp_http_client_event_id_t event)
+{
+    dispatch(event);
+    close();
+    return result;
+}
+
+esp_err_t esp_http_client::close()
+{
+    if (m_state == State::Closed)
+        return ESP_OK;
+
+    m_state = State::Closed;
+    m_rxBegin = m_rxEnd = 0;
+    m_transport->close();
+    dispatch(HTTP_EVENT_DISCONNECTED);
+    return ESP_OK;
+}
+
+void esp_http_client::buildRequest()
+{
+    m_request.clear();
+    m_request += methodNames[m_method];
+    m_request += ' ';
+    m_request += m_target;
+    m_request += " HTTP/1.1\r\n";
+
+    for (const auto &header : m_headers)
+    {
+        m_request += header.key;
+        m_request += ": ";
+        m_request += header.value;
+        m_request += "\r\n";
+    }
+
+    if (m_postLen > 0 || m_method == HTTP_METHOD_POST || m_method == HTTP_METHOD_PUT || m_method == HTTP_METHOD_PATCH)
+    {
+        m_request += "Content-Length: ";
+        appendNumber(m_request, m_postLen);
+        m_request += "\r\n";
+    }
+
+    m_request += "\r\n";
+}
+
+bool esp_http_client::takeLine()
+{
+    const std::string_view available{m_rx.get() + m_rxBegin, m_rxEnd - m_rxBegin};
+    const auto end = available.find('\n');
+
+    m_line.append(available.substr(0, end));
+    m_rxBegin += end == std::string_view::npos ? available.size() : end + 1;
+
+    if (end == std::string_view::npos)
+        return false;
+
+    if (!m_line.empty() && m_line.back() == '\r')
+        m_line.pop_back();
+
+    return true;
+}
+
+esp_http_client::Fill esp_http_client::fill()
+{
+    if (m_rxBegin != m_rxEnd)
+        return Fill::Ok;
+
+    m_rxBegin = m_rxEnd = 0;
+    errno = 0;
+
+    const auto result = m_transport->read(m_rx.get(), m_rxSize);
+    if (result > 0)
+    {
+        m_rxEnd = result;
+        touch();
+        return Fill::Ok;
+    }
+    else if (result == 0)
+        return Fill::Eof;
+    else if (errno == EAGAIN || errno == EWOULDBLOCK)
+        return Fill::WouldBlock;
+
+    return Fill::Error;
+}
+
+bool esp_http_client::parseStatusLine()
+{
+    // HTTP/1.1 200 OK
+    const std::string_view line{m_line};
+
+    if (!line.starts_with("HTTP/1.") || line.size() < 12 || line[8] != ' ' ||
+        std::from_chars(line.data() + 9, line.data() + 12, m_statusCode).ec != std::errc{})
+        return false;
+
+    m_http10 = line[7] == '0';
+    m_keepAlive = !m_http10;
+    m_statusReceived = true;
+    m_line.clear();
+    return true;
+}
+
+void esp_http_client::parseHeaderLine()
+{
+    const auto colon = m_line.find(':');
+    if (colon == std::string::npos)
+    {
+        ESP_LOGW(TAG, "ignoring invalid header line");
+        m_line.clear();
+        return;
+    }
+
+    auto keyEnd = colon;
+    while (keyEnd && m_line[keyEnd - 1] == ' ')
+        keyEnd--;
+
+    auto valueBegin = colon + 1;
+    while (valueBegin < m_line.size() && (m_line[valueBegin] == ' ' || m_line[valueBegin] == '\t'))
+        valueBegin++;
+
+    auto valueEnd = m_line.size();
+    while (valueEnd > valueBegin && (m_line[valueEnd - 1] == ' ' || m_line[valueEnd - 1] == '\t'))
+        valueEnd--;
+
+    const std::string_view key{m_line.data(), keyEnd};
+    const std::string_view value{m_line.data() + valueBegin, valueEnd - valueBegin};
+
+    if (equalsIgnoreCase(key, "Content-Length"))
+        std::from_chars(value.data(), value.data() + value.size(), m_contentLength);
+    else if (equalsIgnoreCase(key, "Transfer-Encoding"))
+        m_chunked = containsToken(value, "chunked");
+    else if (equalsIgnoreCase(key, "Connection"))
+    {
+        if (containsToken(value, "close"))
+            m_keepAlive = false;
+        else if (containsToken(value, "keep-alive"))
+            m_keepAlive = true;
+    }
+
+    // the event handler gets both as c strings, terminate them in place
+    m_line[keyEnd] = '\0';
+    m_line.data()[valueEnd] = '\0';
+    dispatch(HTTP_EVENT_ON_HEADER, nullptr, 0, m_line.data(), m_line.data() + valueBegin);
+
+    m_line.clear();
+}
+
+void esp_http_client::dispatch(esp_http_client_event_id_t id, void *data, int dataLen, char *headerKey, char *headerValue)
+{
+    if (!m_eventHandler)
+        return;
+
+    esp_http_client_event_t event {
+        .event_id = id,
+        .client = this,
+        .data = data,
+        .data_len = dataLen,
+        .user_data = m_userData,
+        .header_key = headerKey,
+        .header_value = headerValue,
+    };
+
+    // like esp_http_client, the return value of the handler is ignored
+    m_eventHandler(&event);
+}
+
+extern "C" {
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *config)
+{
+    if (!config)
+        return nullptr;
+
+    auto client = std::make_unique<esp_http_client>();
+    if (client->init(*config) != ESP_OK)
+        return nullptr;
+
+    return client.release();
+}
+
+esp_err_t esp_http_client_perform(esp_http_client_handle_t client)
+{
+    if (!client)
+        return ESP_ERR_INVALID_ARG;
+
+    return client->perform();
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client)
+{
+    if (!client)
+        return ESP_FAIL;
+
+    client->close();
+    delete client;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_close(esp_http_client_handle_t client)
+{
+    if (!client)
+        return ESP_FAIL;
+
+    return client->close();
+}
+
+esp_err_t esp_http_client_set_url(esp_http_client_handle_t client, const char *url)
+{
+    if (!client || !url)
+        return ESP_ERR_INVALID_ARG;
+
+    return client->setUrl(url);
+}
+
+esp_err_t esp_http_client_set_method(esp_http_client_handle_t client, esp_http_client_method_t method)
+{
+    if (!client || method < 0 || method >= HTTP_METHOD_MAX)
+        return ESP_ERR_INVALID_ARG;
+
+    client->m_method = method;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_timeout_ms(esp_http_client_handle_t client, int timeout_ms)
+{
+    if (!client)
+        return ESP_ERR_INVALID_ARG;
+
+    client->m_timeoutMs = timeout_ms > 0 ? timeout_ms : DEFAULT_TIMEOUT_MS;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char *key, const char *value)
+{
+    if (!client || !key || !value)
+        return ESP_ERR_INVALID_ARG;
+
+    client->setHeader(key, value);
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_get_header(esp_http_client_handle_t client, const char *key, char **value)
+{
+    if (!client || !key || !value)
+        return ESP_ERR_INVALID_ARG;
+
+    *value = nullptr;
+    for (auto &header : client->m_headers)
+        if (equalsIgnoreCase(header.key, key))
+            *value = header.value.data();
+
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_delete_header(esp_http_client_handle_t client, const char *key)
+{
+    if (!client || !key)
+        return ESP_ERR_INVALID_ARG;
+
+    std::erase_if(client->m_headers, [&](const Header &header){ return equalsIgnoreCase(header.key, key); });
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_post_field(esp_http_client_handle_t client, const char *data, int len)
+{
+    if (!client)
+        return ESP_ERR_INVALID_ARG;
+
+    client->m_postData = data;
+    client->m_postLen = data ? (len > 0 ? len : int(std::strlen(data))) : 0;
+    return ESP_OK;
+}
+
+int esp_http_client_get_post_field(esp_http_client_handle_t client, char **data)
+{
+    if (!client || !data)
+        return -1;
+
+    *data = const_cast<char *>(client->m_postData);
+    return client->m_postLen;
+}
+
+esp_err_t esp_http_client_set_user_data(esp_http_client_handle_t client, void *data)
+{
+    if (!client)
+        return ESP_ERR_INVALID_ARG;
+
+    client->m_userData = data;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_get_user_data(esp_http_client_handle_t client, void **data)
+{
+    if (!client || !data)
+        return ESP_ERR_INVALID_ARG;
+
+    *data = client->m_userData;
+    return ESP_OK;
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client)
+{
+    return client ? client->m_statusCode : -1;
+}
+
+int64_t esp_http_client_get_content_length(esp_http_client_handle_t client)
+{
+    return client && !client->m_chunked ? client->m_contentLength : -1;
+}
+
+bool esp_http_client_is_chunked_response(esp_http_client_handle_t client)
+{
+    return client && client->m_chunked;
+}
+
+esp_http_client_transport_t esp_http_client_get_transport_type(esp_http_client_handle_t client)
+{
+    if (!client)
+        return HTTP_TRANSPORT_UNKNOWN;
+
+    return equalsIgnoreCase(client->m_scheme, "https") ? HTTP_TRANSPORT_OVER_SSL : HTTP_TRANSPORT_OVER_TCP;
+}
+
+} // extern "C"
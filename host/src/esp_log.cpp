@@ -0,0 +1,82 @@
+#include "esp_log.h"
+
+// system includes
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// local includes
+#include "esp_timer.h"
+
+namespace {
+struct TagLevel
+{
+    std::string tag;
+    esp_log_level_t level;
+};
+
+std::mutex mutex;
+esp_log_level_t defaultLevel{ESP_LOG_WARN};
+std::vector<TagLevel> tagLevels;
+} // namespace
+
+extern "C" {
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    std::lock_guard lock{mutex};
+
+    if (std::strcmp(tag, "*") == 0)
+    {
+        defaultLevel = level;
+        tagLevels.clear();
+        return;
+    }
+
+    for (auto &entry : tagLevels)
+        if (entry.tag == tag)
+        {
+            entry.level = level;
+            return;
+        }
+
+    tagLevels.push_back(TagLevel{ .tag = tag, .level = level });
+}
+
+esp_log_level_t esp_log_level_get(const char *tag)
+{
+    std::lock_guard lock{mutex};
+
+    for (const auto &entry : tagLevels)
+        if (entry.tag == tag)
+            return entry.level;
+
+    return defaultLevel;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    esp_log_writev(level, tag, format, args);
+    va_end(args);
+}
+
+void esp_log_writev(esp_log_level_t level, const char *tag, const char *format, va_list args)
+{
+    if (level > esp_log_level_get(tag))
+        return;
+
+    flockfile(stderr);
+    std::vfprintf(stderr, format, args);
+    funlockfile(stderr);
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return uint32_t(esp_timer_get_time() / 1000);
+}
+
+} // extern "C"
@@ -0,0 +1,10 @@
+#include "esp_random.h"
+
+// system includes
+#include <random>
+
+extern "C" uint32_t esp_random(void)
+{
+    thread_local std::mt19937 engine{std::random_device{}()};
+    return engine();
+}
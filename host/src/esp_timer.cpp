@@ -0,0 +1,205 @@
+#include "esp_timer.h"
+
+// system includes
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+struct esp_timer
+{
+    esp_timer_cb_t callback;
+    void *arg;
+    std::string name;
+    std::optional<std::chrono::steady_clock::time_point> due;
+    std::chrono::microseconds period{};
+};
+
+namespace {
+// stands in for the esp_timer task, constructed by the first esp_timer_create()
+class TimerService
+{
+public:
+    static TimerService &instance()
+    {
+        static TimerService service;
+        return service;
+    }
+
+    ~TimerService()
+    {
+        {
+            std::lock_guard lock{m_mutex};
+            m_quit = true;
+            m_cv.notify_all();
+        }
+        m_thread.join();
+    }
+
+    void add(esp_timer *timer)
+    {
+        std::lock_guard lock{m_mutex};
+        m_timers.push_back(timer);
+    }
+
+    esp_err_t remove(esp_timer *timer)
+    {
+        std::unique_lock lock{m_mutex};
+        if (timer->due)
+            return ESP_ERR_INVALID_STATE;
+
+        // a callback still running on the dispatch thread must not see its timer freed
+        if (std::this_thread::get_id() != m_thread.get_id())
+            m_cv.wait(lock, [&](){ return m_running != timer; });
+
+        std::erase(m_timers, timer);
+        return ESP_OK;
+    }
+
+    esp_err_t start(esp_timer *timer, std::chrono::microseconds timeout, std::chrono::microseconds period)
+    {
+        std::lock_guard lock{m_mutex};
+        if (timer->due)
+            return ESP_ERR_INVALID_STATE;
+
+        timer->due = std::chrono::steady_clock::now() + timeout;
+        timer->period = period;
+        m_cv.notify_all();
+        return ESP_OK;
+    }
+
+    esp_err_t stop(esp_timer *timer)
+    {
+        std::lock_guard lock{m_mutex};
+        if (!timer->due)
+            return ESP_ERR_INVALID_STATE;
+
+        timer->due = std::nullopt;
+        return ESP_OK;
+    }
+
+    bool active(esp_timer *timer)
+    {
+        std::lock_guard lock{m_mutex};
+        return timer->due.has_value();
+    }
+
+private:
+    TimerService() : m_thread{[this](){ dispatch(); }} {}
+
+    void dispatch()
+    {
+        std::unique_lock lock{m_mutex};
+
+        while (!m_quit)
+        {
+            esp_timer *next{};
+            for (auto *timer : m_timers)
+                if (timer->due && (!next || *timer->due < *next->due))
+                    next = timer;
+
+            if (!next)
+            {
+                m_cv.wait(lock);
+                continue;
+            }
+
+            if (const auto due = *next->due; std::chrono::steady_clock::now() < due)
+            {
+                m_cv.wait_until(lock, due);
+                continue;
+            }
+
+            if (next->period.count())
+                *next->due += next->period;
+            else
+                next->due = std::nullopt;
+
+            m_running = next;
+            lock.unlock();
+            next->callback(next->arg);
+            lock.lock();
+            m_running = nullptr;
+            m_cv.notify_all();
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<esp_timer *> m_timers;
+    esp_timer *m_running{};
+    bool m_quit{};
+    std::thread m_thread;
+};
+} // namespace
+
+extern "C" {
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle)
+{
+    if (!create_args || !create_args->callback || !out_handle)
+        return ESP_ERR_INVALID_ARG;
+
+    auto timer = new esp_timer {
+        .callback = create_args->callback,
+        .arg = create_args->arg,
+        .name = create_args->name ? create_args->name : "",
+    };
+
+    TimerService::instance().add(timer);
+
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    if (!timer)
+        return ESP_ERR_INVALID_ARG;
+
+    return TimerService::instance().start(timer, std::chrono::microseconds{timeout_us}, {});
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+    if (!timer || !period)
+        return ESP_ERR_INVALID_ARG;
+
+    return TimerService::instance().start(timer, std::chrono::microseconds{period}, std::chrono::microseconds{period});
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (!timer)
+        return ESP_ERR_INVALID_ARG;
+
+    return TimerService::instance().stop(timer);
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if (!timer)
+        return ESP_ERR_INVALID_ARG;
+
+    if (const auto result = TimerService::instance().remove(timer); result != ESP_OK)
+        return result;
+
+    delete timer;
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    return timer && TimerService::instance().active(timer);
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // extern "C"
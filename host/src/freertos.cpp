@@ -0,0 +1,289 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+
+// system includes
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <pthread.h>
+
+// local includes
+#include "esp_log.h"
+#include "esp_timer.h"
+
+namespace {
+constexpr const char * const TAG = "FREERTOS";
+
+// host code (getaddrinfo(), fmt, openssl) needs more than the few kilobytes the targets get
+constexpr std::size_t HOST_STACK_SIZE = 512 * 1024;
+
+struct TaskStart
+{
+    TaskFunction_t function;
+    void *parameters;
+    tskTaskControlBlock *tcb;
+};
+
+void *taskThread(void *ptr);
+
+BaseType_t createThread(TaskFunction_t pxTaskCode, const char *pcName, void *pvParameters, TaskHandle_t *pxCreatedTask);
+} // namespace
+
+struct tskTaskControlBlock
+{
+    std::string name;
+    std::mutex mutex;
+    std::condition_variable cv;
+    eTaskState state{eReady};
+};
+
+struct EventGroupDef_t
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    EventBits_t bits{};
+};
+
+namespace {
+thread_local tskTaskControlBlock *currentTask{};
+
+// threads not created through xTaskCreate() still need a handle to compare against
+thread_local std::unique_ptr<tskTaskControlBlock> foreignTask;
+
+void *taskThread(void *ptr)
+{
+    const auto start = *static_cast<TaskStart *>(ptr);
+    delete static_cast<TaskStart *>(ptr);
+
+    // owned by the thread, nobody may touch the handle once the task was deleted
+    std::unique_ptr<tskTaskControlBlock> tcb{start.tcb};
+    currentTask = tcb.get();
+
+    {
+        std::lock_guard lock{tcb->mutex};
+        tcb->state = eRunning;
+    }
+
+    start.function(start.parameters);
+
+    if (std::lock_guard lock{tcb->mutex}; tcb->state != eDeleted)
+        ESP_LOGE(TAG, "task %s returned without deleting itself", tcb->name.c_str());
+
+    currentTask = nullptr;
+    return nullptr;
+}
+
+BaseType_t createThread(TaskFunction_t pxTaskCode, const char *pcName, void *pvParameters, TaskHandle_t *pxCreatedTask)
+{
+    auto tcb = std::make_unique<tskTaskControlBlock>();
+    tcb->name = pcName ? pcName : "";
+
+    // the handle has to be known before the task can observe it
+    if (pxCreatedTask)
+        *pxCreatedTask = tcb.get();
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, HOST_STACK_SIZE);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    auto start = new TaskStart{ .function = pxTaskCode, .parameters = pvParameters, .tcb = tcb.get() };
+
+    pthread_t thread;
+    const auto result = pthread_create(&thread, &attr, taskThread, start);
+    pthread_attr_destroy(&attr);
+
+    if (result != 0)
+    {
+        ESP_LOGE(TAG, "pthread_create() for task %s failed with %i", tcb->name.c_str(), result);
+        delete start;
+        if (pxCreatedTask)
+            *pxCreatedTask = nullptr;
+        return errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+    }
+
+    pthread_setname_np(thread, tcb->name.substr(0, 15).c_str());
+
+    tcb.release();
+    return pdPASS;
+}
+} // namespace
+
+extern "C" {
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pxTaskCode, const char *pcName, uint32_t usStackDepth,
+                                   void *pvParameters, UBaseType_t uxPriority, TaskHandle_t *pxCreatedTask,
+                                   BaseType_t xCoreID)
+{
+    (void)usStackDepth;
+    (void)uxPriority;
+    (void)xCoreID;
+
+    return createThread(pxTaskCode, pcName, pvParameters, pxCreatedTask);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char *pcName, uint32_t usStackDepth,
+                       void *pvParameters, UBaseType_t uxPriority, TaskHandle_t *pxCreatedTask)
+{
+    return xTaskCreatePinnedToCore(pxTaskCode, pcName, usStackDepth, pvParameters, uxPriority, pxCreatedTask, tskNO_AFFINITY);
+}
+
+TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t pxTaskCode, const char *pcName, uint32_t ulStackDepth,
+                                           void *pvParameters, UBaseType_t uxPriority, StackType_t *puxStackBuffer,
+                                           StaticTask_t *pxTaskBuffer, BaseType_t xCoreID)
+{
+    if (!puxStackBuffer || !pxTaskBuffer)
+        return nullptr;
+
+    TaskHandle_t handle{};
+    if (xTaskCreatePinnedToCore(pxTaskCode, pcName, ulStackDepth, pvParameters, uxPriority, &handle, xCoreID) != pdPASS)
+        return nullptr;
+
+    return handle;
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t pxTaskCode, const char *pcName, uint32_t ulStackDepth,
+                               void *pvParameters, UBaseType_t uxPriority, StackType_t *puxStackBuffer,
+                               StaticTask_t *pxTaskBuffer)
+{
+    return xTaskCreateStaticPinnedToCore(pxTaskCode, pcName, ulStackDepth, pvParameters, uxPriority,
+                                         puxStackBuffer, pxTaskBuffer, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete)
+{
+    auto * const tcb = xTaskToDelete ? xTaskToDelete : xTaskGetCurrentTaskHandle();
+
+    std::lock_guard lock{tcb->mutex};
+    tcb->state = eDeleted;
+    tcb->cv.notify_all();
+}
+
+void vTaskSuspend(TaskHandle_t xTaskToSuspend)
+{
+    auto * const tcb = xTaskGetCurrentTaskHandle();
+    if (xTaskToSuspend && xTaskToSuspend != tcb)
+    {
+        ESP_LOGE(TAG, "only the calling task can be suspended on the host");
+        return;
+    }
+
+    std::unique_lock lock{tcb->mutex};
+    tcb->state = eSuspended;
+    tcb->cv.notify_all();
+    tcb->cv.wait(lock, [&](){ return tcb->state != eSuspended; });
+}
+
+void vTaskResume(TaskHandle_t xTaskToResume)
+{
+    std::lock_guard lock{xTaskToResume->mutex};
+    if (xTaskToResume->state == eSuspended)
+    {
+        xTaskToResume->state = eRunning;
+        xTaskToResume->cv.notify_all();
+    }
+}
+
+eTaskState eTaskGetState(TaskHandle_t xTask)
+{
+    if (xTask == xTaskGetCurrentTaskHandle())
+        return eRunning;
+
+    std::lock_guard lock{xTask->mutex};
+    return xTask->state;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    if (currentTask)
+        return currentTask;
+
+    if (!foreignTask)
+    {
+        foreignTask = std::make_unique<tskTaskControlBlock>();
+        foreignTask->state = eRunning;
+    }
+
+    return foreignTask.get();
+}
+
+const char *pcTaskGetName(TaskHandle_t xTaskToQuery)
+{
+    return (xTaskToQuery ? xTaskToQuery : xTaskGetCurrentTaskHandle())->name.c_str();
+}
+
+void vTaskDelay(TickType_t xTicksToDelay)
+{
+    if (xTicksToDelay)
+        std::this_thread::sleep_for(std::chrono::milliseconds{xTicksToDelay * portTICK_PERIOD_MS});
+    else
+        std::this_thread::yield();
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return TickType_t(esp_timer_get_time() / 1000 / portTICK_PERIOD_MS);
+}
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    return new EventGroupDef_t;
+}
+
+void vEventGroupDelete(EventGroupHandle_t xEventGroup)
+{
+    delete xEventGroup;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToWaitFor,
+                                const BaseType_t xClearOnExit, const BaseType_t xWaitForAllBits,
+                                TickType_t xTicksToWait)
+{
+    const auto satisfied = [&](){
+        return xWaitForAllBits ?
+            (xEventGroup->bits & uxBitsToWaitFor) == uxBitsToWaitFor :
+            (xEventGroup->bits & uxBitsToWaitFor) != 0;
+    };
+
+    std::unique_lock lock{xEventGroup->mutex};
+
+    if (xTicksToWait == portMAX_DELAY)
+        xEventGroup->cv.wait(lock, satisfied);
+    else if (xTicksToWait)
+        xEventGroup->cv.wait_for(lock, std::chrono::milliseconds{uint64_t(xTicksToWait) * portTICK_PERIOD_MS}, satisfied);
+
+    const auto bits = xEventGroup->bits;
+    if (xClearOnExit && satisfied())
+        xEventGroup->bits &= ~uxBitsToWaitFor;
+
+    return bits;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet)
+{
+    std::lock_guard lock{xEventGroup->mutex};
+    xEventGroup->bits |= uxBitsToSet;
+    xEventGroup->cv.notify_all();
+    return xEventGroup->bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToClear)
+{
+    std::lock_guard lock{xEventGroup->mutex};
+    const auto bits = xEventGroup->bits;
+    xEventGroup->bits &= ~uxBitsToClear;
+    return bits;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t xEventGroup)
+{
+    std::lock_guard lock{xEventGroup->mutex};
+    return xEventGroup->bits;
+}
+
+} // extern "C"
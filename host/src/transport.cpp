@@ -0,0 +1,437 @@
+#include "transport.h"
+
+// system includes
+#include <cerrno>
+#include <charconv>
+#include <array>
+#include <climits>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+
+// local includes
+#include "esp_log.h"
+
+namespace {
+constexpr const char * const TAG = "TRANSPORT";
+
+class TcpTransport : public Transport
+{
+public:
+    ~TcpTransport() override { close(); }
+
+    int connect(const std::string &host, int port) override;
+    ssize_t write(const char *data, std::size_t size) override;
+    ssize_t read(char *data, std::size_t size) override;
+    void close() override;
+    int fd() const override { return m_fd; }
+    bool wantsWrite() const override { return m_connecting; }
+
+private:
+    int m_fd{-1};
+    bool m_connecting{};
+};
+
+struct SslDeleter
+{
+    void operator()(SSL_CTX *ctx) const { SSL_CTX_free(ctx); }
+    void operator()(SSL *ssl) const { SSL_free(ssl); }
+    void operator()(SSL_SESSION *session) const { SSL_SESSION_free(session); }
+    void operator()(BIO *bio) const { BIO_free(bio); }
+    void operator()(X509 *cert) const { X509_free(cert); }
+    void operator()(EVP_PKEY *key) const { EVP_PKEY_free(key); }
+};
+
+template<typename T>
+using SslPtr = std::unique_ptr<T, SslDeleter>;
+
+// openssl on the tcp socket, the handshake is driven by connect() like esp_transport_ssl does in async mode
+class TlsTransport : public Transport
+{
+public:
+    explicit TlsTransport(const TlsConfig &config) : m_config{config} {}
+    ~TlsTransport() override { close(); }
+
+    int connect(const std::string &host, int port) override;
+    ssize_t write(const char *data, std::size_t size) override;
+    ssize_t read(char *data, std::size_t size) override;
+    void close() override;
+    int fd() const override { return m_tcp.fd(); }
+    bool wantsWrite() const override { return m_tcp.wantsWrite() || m_wantsWrite; }
+
+private:
+    bool createContext();
+    bool createSsl(const std::string &host);
+    //! Translates a failed SSL_* call into errno, returns what read() and write() return then
+    ssize_t failed(int result);
+
+    static int newSession(SSL *ssl, SSL_SESSION *session);
+
+    const TlsConfig m_config;
+    TcpTransport m_tcp;
+    SslPtr<SSL_CTX> m_ctx;
+    SslPtr<SSL> m_ssl;
+    SslPtr<SSL_SESSION> m_session; // the last one the server issued, offered on the next connect()
+    bool m_established{};
+    bool m_wantsWrite{};
+};
+
+void logSslErrors(const char *what)
+{
+    char buf[256];
+    while (const auto error = ERR_get_error())
+    {
+        ERR_error_string_n(error, buf, sizeof(buf));
+        ESP_LOGE(TAG, "%s: %s", what, buf);
+    }
+}
+
+// like BIO_s_socket(), but a peer that is gone does not raise SIGPIPE
+BIO_METHOD *socketBioMethod()
+{
+    static BIO_METHOD * const method = [](){
+        const auto method = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_SOURCE_SINK, "nosigpipe socket");
+
+        BIO_meth_set_write(method, [](BIO *bio, const char *data, int size) -> int {
+            BIO_clear_retry_flags(bio);
+            const auto result = ::send(int(intptr_t(BIO_get_data(bio))), data, size, MSG_NOSIGNAL);
+            if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+                BIO_set_retry_write(bio);
+            return result;
+        });
+
+        BIO_meth_set_read(method, [](BIO *bio, char *data, int size) -> int {
+            BIO_clear_retry_flags(bio);
+            const auto result = ::recv(int(intptr_t(BIO_get_data(bio))), data, size, 0);
+            if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+                BIO_set_retry_read(bio);
+            return result;
+        });
+
+        BIO_meth_set_ctrl(method, [](BIO *, int cmd, long, void *) -> long {
+            return cmd == BIO_CTRL_FLUSH ? 1 : 0;
+        });
+
+        return method;
+    }();
+
+    return method;
+}
+
+int TcpTransport::connect(const std::string &host, int port)
+{
+    if (m_fd >= 0 && !m_connecting)
+        return 1;
+
+    if (m_fd < 0)
+    {
+        std::array<char, 8> service{};
+        std::to_chars(service.data(), service.data() + service.size() - 1, port);
+
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        // name resolution blocks, like it does on the targets
+        addrinfo *addresses{};
+        if (const auto result = getaddrinfo(host.c_str(), service.data(), &hints, &addresses); result != 0)
+        {
+            ESP_LOGE(TAG, "getaddrinfo(%s) failed: %s", host.c_str(), gai_strerror(result));
+            errno = EHOSTUNREACH;
+            return -1;
+        }
+
+        m_fd = ::socket(addresses->ai_family, addresses->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, addresses->ai_protocol);
+        if (m_fd < 0)
+        {
+            freeaddrinfo(addresses);
+            return -1;
+        }
+
+        const int one = 1;
+        setsockopt(m_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        const auto result = ::connect(m_fd, addresses->ai_addr, addresses->ai_addrlen);
+        const auto error = errno;
+        freeaddrinfo(addresses);
+
+        if (result == 0)
+            return 1;
+
+        if (error != EINPROGRESS)
+        {
+            close();
+            errno = error;
+            return -1;
+        }
+
+        m_connecting = true;
+    }
+
+    pollfd pfd{ .fd = m_fd, .events = POLLOUT, .revents = 0 };
+    if (::poll(&pfd, 1, 0) == 0)
+        return 0;
+
+    int error{};
+    socklen_t length = sizeof(error);
+    getsockopt(m_fd, SOL_SOCKET, SO_ERROR, &error, &length);
+    if (error)
+    {
+        close();
+        errno = error;
+        return -1;
+    }
+
+    m_connecting = false;
+    return 1;
+}
+
+ssize_t TcpTransport::write(const char *data, std::size_t size)
+{
+    return ::send(m_fd, data, size, MSG_NOSIGNAL);
+}
+
+ssize_t TcpTransport::read(char *data, std::size_t size)
+{
+    return ::recv(m_fd, data, size, 0);
+}
+
+void TcpTransport::close()
+{
+    if (m_fd < 0)
+        return;
+
+    ::close(m_fd);
+    m_fd = -1;
+    m_connecting = false;
+}
+
+int TlsTransport::connect(const std::string &host, int port)
+{
+    if (m_established)
+        return 1;
+
+    if (!m_ssl)
+    {
+        if (const auto result = m_tcp.connect(host, port); result <= 0)
+            return result;
+
+        if ((!m_ctx && !createContext()) || !createSsl(host))
+        {
+            close();
+            errno = EPROTO;
+            return -1;
+        }
+    }
+
+    ERR_clear_error();
+    if (const auto result = SSL_connect(m_ssl.get()); result != 1)
+    {
+        if (failed(result) < 0 && errno == EAGAIN)
+            return 0;
+
+        if (const auto verify = SSL_get_verify_result(m_ssl.get()); verify != X509_V_OK)
+            ESP_LOGE(TAG, "tls handshake with %s failed: %s", host.c_str(), X509_verify_cert_error_string(verify));
+        logSslErrors("tls handshake failed");
+
+        const auto error = errno ? errno : ECONNREFUSED;
+        close();
+        errno = error;
+        return -1;
+    }
+
+    m_established = true;
+    m_wantsWrite = false;
+    return 1;
+}
+
+ssize_t TlsTransport::write(const char *data, std::size_t size)
+{
+    if (!m_established)
+    {
+        errno = ENOTCONN;
+        return -1;
+    }
+
+    ERR_clear_error();
+    const auto result = SSL_write(m_ssl.get(), data, int(std::min<std::size_t>(size, INT_MAX)));
+    return result > 0 ? result : failed(result);
+}
+
+ssize_t TlsTransport::read(char *data, std::size_t size)
+{
+    if (!m_established)
+    {
+        errno = ENOTCONN;
+        return -1;
+    }
+
+    ERR_clear_error();
+    const auto result = SSL_read(m_ssl.get(), data, int(std::min<std::size_t>(size, INT_MAX)));
+    return result > 0 ? result : failed(result);
+}
+
+void TlsTransport::close()
+{
+    if (m_ssl)
+    {
+        // without sending close_notify, but marked as shut down so the session stays resumable
+        SSL_set_quiet_shutdown(m_ssl.get(), 1);
+        SSL_shutdown(m_ssl.get());
+        m_ssl = nullptr;
+    }
+
+    m_tcp.close();
+    m_established = false;
+    m_wantsWrite = false;
+}
+
+bool TlsTransport::createContext()
+{
+    m_ctx.reset(SSL_CTX_new(TLS_client_method()));
+    if (!m_ctx)
+    {
+        logSslErrors("SSL_CTX_new() failed");
+        return false;
+    }
+
+    SSL_CTX_set_mode(m_ctx.get(), SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+    // responses delimited by the end of the connection are common, esp-tls does not insist on close_notify either
+    SSL_CTX_set_options(m_ctx.get(), SSL_OP_IGNORE_UNEXPECTED_EOF);
+
+    if (m_config.saveSession)
+    {
+        SSL_CTX_set_session_cache_mode(m_ctx.get(), SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_sess_set_new_cb(m_ctx.get(), newSession);
+    }
+
+    if (!m_config.serverCert.empty())
+    {
+        SslPtr<BIO> bio{BIO_new_mem_buf(m_config.serverCert.data(), int(m_config.serverCert.size()))};
+        const auto certs = PEM_X509_INFO_read_bio(bio.get(), nullptr, nullptr, nullptr);
+        if (!certs || !sk_X509_INFO_num(certs))
+        {
+            logSslErrors("cert_pem could not be parsed");
+            sk_X509_INFO_pop_free(certs, X509_INFO_free);
+            return false;
+        }
+
+        const auto store = SSL_CTX_get_cert_store(m_ctx.get());
+        for (int i = 0; i < sk_X509_INFO_num(certs); i++)
+            if (const auto info = sk_X509_INFO_value(certs, i); info->x509)
+                X509_STORE_add_cert(store, info->x509);
+        sk_X509_INFO_pop_free(certs, X509_INFO_free);
+
+        SSL_CTX_set_verify(m_ctx.get(), SSL_VERIFY_PEER, nullptr);
+    }
+    else
+        ESP_LOGW(TAG, "no cert_pem, the server is not verified");
+
+    if (!m_config.clientCert.empty() && !m_config.clientKey.empty())
+    {
+        SslPtr<BIO> certBio{BIO_new_mem_buf(m_config.clientCert.data(), int(m_config.clientCert.size()))};
+        SslPtr<BIO> keyBio{BIO_new_mem_buf(m_config.clientKey.data(), int(m_config.clientKey.size()))};
+        SslPtr<X509> cert{PEM_read_bio_X509(certBio.get(), nullptr, nullptr, nullptr)};
+        SslPtr<EVP_PKEY> key{PEM_read_bio_PrivateKey(keyBio.get(), nullptr, nullptr, nullptr)};
+
+        if (!cert || !key || SSL_CTX_use_certificate(m_ctx.get(), cert.get()) != 1 || SSL_CTX_use_PrivateKey(m_ctx.get(), key.get()) != 1)
+        {
+            logSslErrors("client certificate could not be used");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool TlsTransport::createSsl(const std::string &host)
+{
+    m_ssl.reset(SSL_new(m_ctx.get()));
+    const auto bio = BIO_new(socketBioMethod());
+    if (!m_ssl || !bio)
+    {
+        BIO_free(bio);
+        logSslErrors("SSL_new() failed");
+        return false;
+    }
+
+    BIO_set_data(bio, (void *)intptr_t(m_tcp.fd()));
+    BIO_set_init(bio, 1);
+    SSL_set_bio(m_ssl.get(), bio, bio);
+    SSL_set_app_data(m_ssl.get(), this);
+
+    in6_addr address;
+    const bool ipAddress = inet_pton(AF_INET, host.c_str(), &address) == 1 || inet_pton(AF_INET6, host.c_str(), &address) == 1;
+
+    if (!ipAddress)
+        SSL_set_tlsext_host_name(m_ssl.get(), host.c_str());
+
+    if (!m_config.serverCert.empty() && !m_config.skipCommonNameCheck)
+    {
+        const auto param = SSL_get0_param(m_ssl.get());
+        if (!m_config.commonName.empty())
+            X509_VERIFY_PARAM_set1_host(param, m_config.commonName.data(), m_config.commonName.size());
+        else if (ipAddress)
+            X509_VERIFY_PARAM_set1_ip_asc(param, host.c_str());
+        else
+            X509_VERIFY_PARAM_set1_host(param, host.c_str(), host.size());
+    }
+
+    if (m_session)
+        SSL_set_session(m_ssl.get(), m_session.get());
+
+    return true;
+}
+
+ssize_t TlsTransport::failed(int result)
+{
+    const auto error = errno;
+
+    switch (SSL_get_error(m_ssl.get(), result))
+    {
+    case SSL_ERROR_WANT_READ:
+        m_wantsWrite = false;
+        errno = EAGAIN;
+        return -1;
+    case SSL_ERROR_WANT_WRITE:
+        m_wantsWrite = true;
+        errno = EAGAIN;
+        return -1;
+    case SSL_ERROR_ZERO_RETURN:
+        return 0;
+    case SSL_ERROR_SYSCALL:
+        errno = error ? error : ECONNRESET;
+        return -1;
+    default:
+        logSslErrors("tls error");
+        errno = EPROTO;
+        return -1;
+    }
+}
+
+int TlsTransport::newSession(SSL *ssl, SSL_SESSION *session)
+{
+    // tls 1.3 servers may issue several tickets, the last one is kept
+    static_cast<TlsTransport *>(SSL_get_app_data(ssl))->m_session.reset(session);
+    return 1;
+}
+} // namespace
+
+std::unique_ptr<Transport> makeTcpTransport()
+{
+    return std::make_unique<TcpTransport>();
+}
+
+std::unique_ptr<Transport> makeTlsTransport(const TlsConfig &config)
+{
+    return std::make_unique<TlsTransport>(config);
+}
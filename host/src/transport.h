@@ -0,0 +1,44 @@
+#pragma once
+
+// system includes
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+
+// byte stream under the host esp_http_client, every call is non-blocking
+class Transport
+{
+public:
+    virtual ~Transport() = default;
+
+    //! 1 once connected, 0 while still in progress, -1 with errno set on failure
+    virtual int connect(const std::string &host, int port) = 0;
+
+    //! like send() and recv(), -1 with errno EAGAIN when the socket would block
+    virtual ssize_t write(const char *data, std::size_t size) = 0;
+    virtual ssize_t read(char *data, std::size_t size) = 0;
+
+    virtual void close() = 0;
+
+    //! the socket to poll() on, -1 while closed
+    virtual int fd() const = 0;
+
+    //! which direction a blocked call waits for, a tls record may need to write while reading
+    virtual bool wantsWrite() const { return false; }
+};
+
+//! What esp_http_client_config_t passes on to the tls transport, the pem buffers have to outlive it
+struct TlsConfig
+{
+    std::string_view serverCert; // without one the server is not verified, there is no certificate bundle on the host
+    std::string_view clientCert;
+    std::string_view clientKey;
+    std::string_view commonName; // checked instead of the host when set
+    bool skipCommonNameCheck{};
+    bool saveSession{};          // offer the session of the last connection when reconnecting
+};
+
+std::unique_ptr<Transport> makeTcpTransport();
+std::unique_ptr<Transport> makeTlsTransport(const TlsConfig &config);
@@ -0,0 +1,40 @@
+#include "asynchttpawaitable.h"
+
+AsyncHttpAwaitable::AsyncHttpAwaitable(AsyncHttpRequest &request, std::expected<void, std::string> started) :
+    m_request{request}
+{
+    if (!started)
+        m_startError = std::move(started).error();
+}
+
+bool AsyncHttpAwaitable::await_ready() const
+{
+    return m_startError || m_request.finished();
+}
+
+bool AsyncHttpAwaitable::await_suspend(std::coroutine_handle<> coroutine)
+{
+    m_request.m_awaitingCoroutine = coroutine.address();
+
+    // the request might have finished before the handle was stored
+    if (m_request.finished() && m_request.m_awaitingCoroutine.exchange(nullptr) == coroutine.address())
+        return false;
+
+    return true;
+}
+
+std::expected<AsyncHttpResponse, AsyncHttpError> AsyncHttpAwaitable::await_resume()
+{
+    if (m_startError)
+        return std::unexpected(AsyncHttpError{ .code = ESP_FAIL, .message = std::move(*m_startError) });
+
+    // resumed by the completion handlers the request still counts as running, result() would refuse
+    if (auto result = m_request.finishedResult(); !result)
+        return std::unexpected(AsyncHttpError{ .code = m_request.m_result, .message = std::move(result).error() });
+
+    return AsyncHttpResponse {
+        .statusCode = m_request.statusCode(),
+        .body = m_request.takeBuffer(),
+        .headers = m_request.takeResponseHeaders(),
+    };
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+// system includes
+#include <string>
+#include <optional>
+#include <expected>
+#include <coroutine>
+#include <utility>
+
+// esp-idf includes
+#include <esp_err.h>
+
+// local includes
+#include "asynchttprequest.h"
+#include "asynchttpcapsallocator.h"
+#include "asynchttpheaders.h"
+
+struct AsyncHttpResponse
+{
+    int statusCode{};
+    //! Empty when the body went into a sink, a response buffer or the segmented buffer
+    AsyncHttpString body;
+    //! Only filled when collectResponseHeaders() is enabled
+    AsyncHttpHeaders headers;
+};
+
+struct AsyncHttpError
+{
+    esp_err_t code{};
+    std::string message;
+};
+
+//! Returned by AsyncHttpRequest::startAsync(). The request is started right away, co_await
+//! suspends until it finished and resumes the coroutine inside the request task (or worker).
+//! The request has to outlive the awaiting coroutine.
+class AsyncHttpAwaitable
+{
+public:
+    AsyncHttpAwaitable(AsyncHttpRequest &request, std::expected<void, std::string> started);
+
+    bool await_ready() const;
+    bool await_suspend(std::coroutine_handle<> coroutine);
+    std::expected<AsyncHttpResponse, AsyncHttpError> await_resume();
+
+private:
+    AsyncHttpRequest &m_request;
+    std::optional<std::string> m_startError;
+};
+
+template<typename ...Args>
+AsyncHttpAwaitable AsyncHttpRequest::startAsync(Args &&...args)
+{
+    return AsyncHttpAwaitable{*this, startNow(std::forward<Args>(args)...)};
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+// system includes
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+// esp-idf includes
+#include <esp_heap_caps.h>
+
+//! Allocates from the heap selected by caps with heap_caps_malloc(), e.g. MALLOC_CAP_SPIRAM.
+//! Containers take the caps of the container they are moved or copied from.
+template<typename T>
+class AsyncHttpCapsAllocator
+{
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    AsyncHttpCapsAllocator() noexcept = default;
+    explicit AsyncHttpCapsAllocator(uint32_t caps) noexcept : m_caps{caps} {}
+    template<typename U>
+    AsyncHttpCapsAllocator(const AsyncHttpCapsAllocator<U> &other) noexcept : m_caps{other.caps()} {}
+
+    T *allocate(std::size_t count)
+    {
+        if (auto ptr = heap_caps_malloc(count * sizeof(T), m_caps))
+            return static_cast<T *>(ptr);
+        throw std::bad_alloc{};
+    }
+    void deallocate(T *ptr, std::size_t) noexcept { heap_caps_free(ptr); }
+
+    uint32_t caps() const { return m_caps; }
+
+    template<typename U>
+    bool operator==(const AsyncHttpCapsAllocator<U> &other) const { return m_caps == other.caps(); }
+
+private:
+    uint32_t m_caps{MALLOC_CAP_DEFAULT};
+};
+
+//! std::string on the heap selected by its allocator, converts to std::string_view
+using AsyncHttpString = std::basic_string<char, std::char_traits<char>, AsyncHttpCapsAllocator<char>>;
@@ -0,0 +1,283 @@
+#include "asynchttpconnectionpool.h"
+
+#include "sdkconfig.h"
+#define LOG_LOCAL_LEVEL CONFIG_LOG_LOCAL_LEVEL_ASYNC_HTTP
+
+// system includes
+#include <algorithm>
+#include <iterator>
+
+// esp-idf includes
+#include <esp_log.h>
+#include <esp_http_client.h>
+
+using namespace std::chrono_literals;
+
+namespace {
+constexpr const char * const TAG = "ASYNC_HTTP";
+} // namespace
+
+AsyncHttpConnectionPool &AsyncHttpConnectionPool::instance()
+{
+    static AsyncHttpConnectionPool pool;
+    return pool;
+}
+
+AsyncHttpConnectionPool::AsyncHttpConnectionPool() :
+    m_maxPerOrigin{CONFIG_ASYNC_HTTP_POOL_MAX_PER_ORIGIN},
+    m_maxTotal{CONFIG_ASYNC_HTTP_POOL_MAX_TOTAL},
+    m_idleTimeout{CONFIG_ASYNC_HTTP_POOL_IDLE_TIMEOUT_MS},
+    m_maxSessionsPerOrigin{CONFIG_ASYNC_HTTP_TLS_SESSIONS_PER_ORIGIN},
+    m_sessionTimeout{CONFIG_ASYNC_HTTP_TLS_SESSION_TIMEOUT_MS}
+{
+    const esp_timer_create_args_t args {
+        .callback = evictTimerCallback,
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "httpPoolEvict",
+    };
+
+    if (const auto result = esp_timer_create(&args, &m_evictTimer); result != ESP_OK)
+    {
+        ESP_LOGE(TAG, "esp_timer_create() failed with %s, idle connections are only evicted on checkout and checkin", esp_err_to_name(result));
+        m_evictTimer = {};
+    }
+}
+
+AsyncHttpConnectionPool::~AsyncHttpConnectionPool()
+{
+    if (m_evictTimer)
+    {
+        esp_timer_stop(m_evictTimer);
+        esp_timer_delete(m_evictTimer);
+    }
+}
+
+void AsyncHttpConnectionPool::evictTimerCallback(void *arg)
+{
+    static_cast<AsyncHttpConnectionPool*>(arg)->evictIdle();
+}
+
+auto AsyncHttpConnectionPool::checkout(const AsyncHttpOrigin &origin) -> std::optional<Pooled>
+{
+    std::vector<espcpputils::http_client> evicted;
+    std::lock_guard lock{m_mutex};
+
+    evictLocked(evicted);
+
+    auto iter = std::find_if(std::rbegin(m_entries), std::rend(m_entries), [&](const Entry &entry){ return entry.connected && entry.origin == origin; });
+    if (iter == std::rend(m_entries))
+        iter = std::find_if(std::rbegin(m_entries), std::rend(m_entries), [&](const Entry &entry){ return entry.origin == origin; });
+
+    if (iter == std::rend(m_entries))
+    {
+        m_stats.misses++;
+        return std::nullopt;
+    }
+
+    if (iter->connected)
+        m_stats.hits++;
+    else
+        m_stats.sessionHits++;
+
+    Pooled pooled {
+        .client = std::move(iter->client),
+        .connected = iter->connected,
+        .hasSession = iter->hasSession,
+    };
+    m_entries.erase(std::next(iter).base());
+
+    ESP_LOGD(TAG, "checked out pooled %s to %s:%hu", pooled.connected ? "connection" : "tls session", origin.host.c_str(), origin.port);
+
+    return pooled;
+}
+
+void AsyncHttpConnectionPool::checkin(const AsyncHttpOrigin &origin, espcpputils::http_client &&client, bool connected, bool hasSession)
+{
+    if (!client)
+        return;
+
+    // the event handler must not be called for the previous owner anymore
+    esp_http_client_set_user_data(client.handle, nullptr);
+
+    std::vector<espcpputils::http_client> evicted;
+    std::lock_guard lock{m_mutex};
+
+    if (!connected && !hasSession)
+    {
+        // nothing worth keeping, destroyed after unlocking
+        evicted.push_back(std::move(client));
+        return;
+    }
+
+    m_entries.push_back(Entry {
+        .origin = origin,
+        .client = std::move(client),
+        .connected = connected,
+        .hasSession = hasSession,
+        .idleSince = espchrono::millis_clock::now(),
+    });
+
+    evictLocked(evicted);
+}
+
+void AsyncHttpConnectionPool::evictIdle()
+{
+    std::vector<espcpputils::http_client> evicted;
+    std::lock_guard lock{m_mutex};
+    evictLocked(evicted);
+}
+
+void AsyncHttpConnectionPool::clear()
+{
+    std::vector<Entry> entries;
+    std::lock_guard lock{m_mutex};
+    m_stats.evictions += m_entries.size();
+    std::swap(entries, m_entries);
+    scheduleEvictionLocked();
+}
+
+std::size_t AsyncHttpConnectionPool::maxPerOrigin() const
+{
+    std::lock_guard lock{m_mutex};
+    return m_maxPerOrigin;
+}
+
+void AsyncHttpConnectionPool::setMaxPerOrigin(std::size_t maxPerOrigin)
+{
+    std::vector<espcpputils::http_client> evicted;
+    std::lock_guard lock{m_mutex};
+    m_maxPerOrigin = maxPerOrigin;
+    evictLocked(evicted);
+}
+
+std::size_t AsyncHttpConnectionPool::maxTotal() const
+{
+    std::lock_guard lock{m_mutex};
+    return m_maxTotal;
+}
+
+void AsyncHttpConnectionPool::setMaxTotal(std::size_t maxTotal)
+{
+    std::vector<espcpputils::http_client> evicted;
+    std::lock_guard lock{m_mutex};
+    m_maxTotal = maxTotal;
+    evictLocked(evicted);
+}
+
+std::chrono::milliseconds AsyncHttpConnectionPool::idleTimeout() const
+{
+    std::lock_guard lock{m_mutex};
+    return m_idleTimeout;
+}
+
+void AsyncHttpConnectionPool::setIdleTimeout(std::chrono::milliseconds idleTimeout)
+{
+    std::vector<espcpputils::http_client> evicted;
+    std::lock_guard lock{m_mutex};
+    m_idleTimeout = idleTimeout;
+    evictLocked(evicted);
+}
+
+std::size_t AsyncHttpConnectionPool::maxSessionsPerOrigin() const
+{
+    std::lock_guard lock{m_mutex};
+    return m_maxSessionsPerOrigin;
+}
+
+void AsyncHttpConnectionPool::setMaxSessionsPerOrigin(std::size_t maxSessionsPerOrigin)
+{
+    std::vector<espcpputils::http_client> evicted;
+    std::lock_guard lock{m_mutex};
+    m_maxSessionsPerOrigin = maxSessionsPerOrigin;
+    evictLocked(evicted);
+}
+
+std::chrono::milliseconds AsyncHttpConnectionPool::sessionTimeout() const
+{
+    std::lock_guard lock{m_mutex};
+    return m_sessionTimeout;
+}
+
+void AsyncHttpConnectionPool::setSessionTimeout(std::chrono::milliseconds sessionTimeout)
+{
+    std::vector<espcpputils::http_client> evicted;
+    std::lock_guard lock{m_mutex};
+    m_sessionTimeout = sessionTimeout;
+    evictLocked(evicted);
+}
+
+auto AsyncHttpConnectionPool::stats() const -> Stats
+{
+    std::lock_guard lock{m_mutex};
+    auto stats = m_stats;
+    stats.sessions = std::count_if(std::cbegin(m_entries), std::cend(m_entries), [](const Entry &entry){ return !entry.connected; });
+    stats.idle = m_entries.size() - stats.sessions;
+    return stats;
+}
+
+void AsyncHttpConnectionPool::evictLocked(std::vector<espcpputils::http_client> &evicted)
+{
+    const auto evict = [&](std::vector<Entry>::iterator iter){
+        ESP_LOGD(TAG, "evicting pooled connection to %s:%hu", iter->origin.host.c_str(), iter->origin.port);
+        evicted.push_back(std::move(iter->client));
+        m_stats.evictions++;
+        return m_entries.erase(iter);
+    };
+
+    const auto now = espchrono::millis_clock::now();
+    for (auto iter = std::begin(m_entries); iter != std::end(m_entries); )
+    {
+        if (iter->connected && iter->hasSession && now - iter->idleSince >= m_idleTimeout)
+        {
+            // the tls session outlives the connection
+            iter->client.close();
+            iter->connected = false;
+        }
+
+        if (now - iter->idleSince >= (iter->connected ? m_idleTimeout : m_sessionTimeout))
+        {
+            iter = evict(iter);
+            continue;
+        }
+
+        // counts itself and all more recently used entries of the same origin and kind
+        const auto newer = std::count_if(iter, std::end(m_entries), [&](const Entry &entry){
+            return entry.connected == iter->connected && entry.origin == iter->origin;
+        });
+        if (std::size_t(newer) > (iter->connected ? m_maxPerOrigin : m_maxSessionsPerOrigin))
+            iter = evict(iter);
+        else
+            iter++;
+    }
+
+    while (m_entries.size() > m_maxTotal)
+        evict(std::begin(m_entries));
+
+    scheduleEvictionLocked();
+}
+
+void AsyncHttpConnectionPool::scheduleEvictionLocked()
+{
+    if (!m_evictTimer)
+        return;
+
+    esp_timer_stop(m_evictTimer);
+
+    if (m_entries.empty())
+        return;
+
+    std::optional<espchrono::millis_clock::time_point> next;
+    for (const auto &entry : m_entries)
+    {
+        // a connected entry holding a session is closed after m_idleTimeout as well
+        const auto expires = entry.idleSince + (entry.connected ? m_idleTimeout : m_sessionTimeout);
+        if (!next || expires < *next)
+            next = expires;
+    }
+
+    const std::chrono::milliseconds remaining = *next - espchrono::millis_clock::now();
+    const auto timeout = std::max<std::chrono::microseconds>(remaining, 1ms);
+    if (const auto result = esp_timer_start_once(m_evictTimer, timeout.count()); result != ESP_OK)
+        ESP_LOGW(TAG, "esp_timer_start_once() failed with %s", esp_err_to_name(result));
+}
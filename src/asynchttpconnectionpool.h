@@ -0,0 +1,102 @@
+#pragma once
+
+// system includes
+#include <vector>
+#include <mutex>
+#include <optional>
+#include <chrono>
+
+// esp-idf includes
+#include <esp_timer.h>
+
+// 3rdparty lib includes
+#include <wrappers/http_client.h>
+#include <espchrono.h>
+
+// local includes
+#include "asynchttporigin.h"
+
+//! Process-wide pool of idle kept-alive http clients, so requests of different
+//! AsyncHttpRequest instances to the same origin can share connections. Clients
+//! whose connection is already closed are kept as well when they hold a tls
+//! session, so the next connection to that origin can resume it.
+//! A timer closes clients once they exceed their idle timeout.
+class AsyncHttpConnectionPool
+{
+public:
+    struct Stats
+    {
+        std::size_t hits{};
+        std::size_t sessionHits{};
+        std::size_t misses{};
+        std::size_t evictions{};
+        std::size_t idle{};
+        std::size_t sessions{};
+    };
+
+    struct Pooled
+    {
+        espcpputils::http_client client;
+        bool connected{};
+        bool hasSession{};
+    };
+
+    static AsyncHttpConnectionPool &instance();
+
+    //! Returns the most recently used idle client for origin, preferring open connections
+    //! over cached tls sessions. Its user_data still has to be updated.
+    std::optional<Pooled> checkout(const AsyncHttpOrigin &origin);
+    //! Hands over an idle client, the caller has to reset headers and post field first
+    void checkin(const AsyncHttpOrigin &origin, espcpputils::http_client &&client, bool connected, bool hasSession);
+
+    //! Closes clients that exceeded the idle timeout, also done by the eviction timer
+    void evictIdle();
+    void clear();
+
+    std::size_t maxPerOrigin() const;
+    void setMaxPerOrigin(std::size_t maxPerOrigin);
+
+    std::size_t maxTotal() const;
+    void setMaxTotal(std::size_t maxTotal);
+
+    std::chrono::milliseconds idleTimeout() const;
+    void setIdleTimeout(std::chrono::milliseconds idleTimeout);
+
+    std::size_t maxSessionsPerOrigin() const;
+    void setMaxSessionsPerOrigin(std::size_t maxSessionsPerOrigin);
+
+    std::chrono::milliseconds sessionTimeout() const;
+    void setSessionTimeout(std::chrono::milliseconds sessionTimeout);
+
+    Stats stats() const;
+
+private:
+    AsyncHttpConnectionPool();
+    ~AsyncHttpConnectionPool();
+
+    struct Entry
+    {
+        AsyncHttpOrigin origin;
+        espcpputils::http_client client;
+        bool connected;
+        bool hasSession;
+        espchrono::millis_clock::time_point idleSince;
+    };
+
+    // the evicted clients are destroyed by the caller after unlocking
+    void evictLocked(std::vector<espcpputils::http_client> &evicted);
+    // arms m_evictTimer for the entry expiring next
+    void scheduleEvictionLocked();
+
+    static void evictTimerCallback(void *arg);
+
+    mutable std::mutex m_mutex;
+    std::vector<Entry> m_entries; // least recently used first
+    std::size_t m_maxPerOrigin;
+    std::size_t m_maxTotal;
+    std::chrono::milliseconds m_idleTimeout;
+    std::size_t m_maxSessionsPerOrigin;
+    std::chrono::milliseconds m_sessionTimeout;
+    Stats m_stats;
+    esp_timer_handle_t m_evictTimer{};
+};
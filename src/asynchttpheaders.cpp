@@ -0,0 +1,122 @@
+#include "asynchttpheaders.h"
+
+// system includes
+#include <algorithm>
+#include <limits>
+#include <cctype>
+
+bool AsyncHttpHeaders::nameEquals(std::string_view a, std::string_view b)
+{
+    return a.size() == b.size() &&
+           std::equal(std::begin(a), std::end(a), std::begin(b), [](unsigned char x, unsigned char y){
+               return std::tolower(x) == std::tolower(y);
+           });
+}
+
+void AsyncHttpHeaders::setCaps(uint32_t caps)
+{
+    m_arena = AsyncHttpString{AsyncHttpCapsAllocator<char>{caps}};
+    m_index = std::vector<Entry, AsyncHttpCapsAllocator<Entry>>{AsyncHttpCapsAllocator<Entry>{caps}};
+}
+
+void AsyncHttpHeaders::clear()
+{
+    m_arena.clear();
+    m_index.clear();
+}
+
+void AsyncHttpHeaders::reserve(std::size_t bytes, std::size_t count)
+{
+    m_arena.reserve(bytes);
+    m_index.reserve(count);
+}
+
+void AsyncHttpHeaders::append(std::string_view name, std::string_view value)
+{
+    constexpr std::size_t maxLength = std::numeric_limits<uint16_t>::max();
+    name = name.substr(0, maxLength);
+    value = value.substr(0, maxLength);
+
+    m_index.push_back(Entry {
+        .offset = uint32_t(m_arena.size()),
+        .nameLength = uint16_t(name.size()),
+        .valueLength = uint16_t(value.size()),
+    });
+
+    m_arena += name;
+    m_arena += value;
+}
+
+auto AsyncHttpHeaders::operator[](std::size_t index) const -> Header
+{
+    const auto &entry = m_index[index];
+    const std::string_view arena{m_arena};
+    return Header {
+        .name = arena.substr(entry.offset, entry.nameLength),
+        .value = arena.substr(entry.offset + entry.nameLength, entry.valueLength),
+    };
+}
+
+std::optional<std::string_view> AsyncHttpHeaders::find(std::string_view name) const
+{
+    for (const auto header : *this)
+        if (nameEquals(header.name, name))
+            return header.value;
+
+    return std::nullopt;
+}
+
+std::size_t AsyncHttpHeaders::count(std::string_view name) const
+{
+    return std::count_if(begin(), end(), [&](const Header &header){ return nameEquals(header.name, name); });
+}
+
+std::map<std::string, std::string> AsyncHttpHeaders::toMap() const
+{
+    std::map<std::string, std::string> map;
+    for (const auto header : *this)
+        map.emplace(header.name, header.value);
+    return map;
+}
+
+std::size_t AsyncHttpHeaders::allocatedBytes() const
+{
+    // short arenas live inside the string object itself
+    const auto data = m_arena.data();
+    const bool external = !(data >= (const char *)&m_arena && data < (const char *)(&m_arena + 1));
+    return (external ? m_arena.capacity() + 1 : 0) + m_index.capacity() * sizeof(Entry);
+}
+
+AsyncHttpHeaderFilter::AsyncHttpHeaderFilter(std::span<const std::string_view> names) :
+    m_names(std::begin(names), std::end(names))
+{
+    std::sort(std::begin(m_names), std::end(m_names), nameLess);
+    m_names.erase(std::unique(std::begin(m_names), std::end(m_names), AsyncHttpHeaders::nameEquals), std::end(m_names));
+
+    if (!m_names.empty())
+    {
+        const auto [min, max] = std::minmax_element(std::begin(m_names), std::end(m_names), [](std::string_view a, std::string_view b){ return a.size() < b.size(); });
+        m_minLength = min->size();
+        m_maxLength = max->size();
+    }
+}
+
+bool AsyncHttpHeaderFilter::matches(std::string_view name) const
+{
+    if (m_names.empty())
+        return true;
+
+    // cheap rejection before the binary search
+    if (name.size() < m_minLength || name.size() > m_maxLength)
+        return false;
+
+    const auto iter = std::lower_bound(std::begin(m_names), std::end(m_names), name, nameLess);
+    return iter != std::end(m_names) && AsyncHttpHeaders::nameEquals(*iter, name);
+}
+
+bool AsyncHttpHeaderFilter::nameLess(std::string_view a, std::string_view b)
+{
+    return std::lexicographical_compare(std::begin(a), std::end(a), std::begin(b), std::end(b), [](unsigned char x, unsigned char y){
+        return std::tolower(x) < std::tolower(y);
+    });
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+// system includes
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <optional>
+#include <span>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+
+// local includes
+#include "asynchttpcapsallocator.h"
+
+//! Request header passed by reference, both views have to be null-terminated (string literals usually)
+using AsyncHttpHeaderView = std::pair<std::string_view, std::string_view>;
+
+//! Compact store for response headers: all names and values live in one arena
+//! string, a small index vector points into it. Lookups ignore the case of the
+//! name and repeated headers (like Set-Cookie) are kept as separate entries.
+//! clear() keeps the allocated capacity for the next response.
+class AsyncHttpHeaders
+{
+public:
+    struct Header
+    {
+        std::string_view name;
+        std::string_view value;
+    };
+
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Header;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Header;
+
+        const_iterator() = default;
+        const_iterator(const AsyncHttpHeaders *headers, std::size_t index) : m_headers{headers}, m_index{index} {}
+
+        Header operator*() const { return (*m_headers)[m_index]; }
+        const_iterator &operator++() { m_index++; return *this; }
+        const_iterator operator++(int) { auto copy = *this; m_index++; return copy; }
+        bool operator==(const const_iterator &other) const = default;
+
+    private:
+        const AsyncHttpHeaders *m_headers{};
+        std::size_t m_index{};
+    };
+
+    static bool nameEquals(std::string_view a, std::string_view b);
+
+    AsyncHttpHeaders() = default;
+    //! caps select the heap arena and index are allocated from, e.g. MALLOC_CAP_SPIRAM
+    explicit AsyncHttpHeaders(uint32_t caps) : m_arena{AsyncHttpCapsAllocator<char>{caps}}, m_index{AsyncHttpCapsAllocator<Entry>{caps}} {}
+
+    uint32_t caps() const { return m_arena.get_allocator().caps(); }
+    //! Clears the headers and releases their memory, following ones are allocated with the new caps
+    void setCaps(uint32_t caps);
+
+    void clear();
+    void reserve(std::size_t bytes, std::size_t count);
+    void append(std::string_view name, std::string_view value);
+
+    std::size_t size() const { return m_index.size(); }
+    bool empty() const { return m_index.empty(); }
+
+    Header operator[](std::size_t index) const;
+    const_iterator begin() const { return {this, 0}; }
+    const_iterator end() const { return {this, m_index.size()}; }
+
+    //! First value of the header with the given name (case-insensitive)
+    std::optional<std::string_view> find(std::string_view name) const;
+    bool contains(std::string_view name) const { return find(name).has_value(); }
+    std::size_t count(std::string_view name) const;
+
+    //! Calls callback(std::string_view value) for every header with the given name
+    template<typename Callback>
+    void forEach(std::string_view name, Callback &&callback) const
+    {
+        for (const auto header : *this)
+            if (nameEquals(header.name, name))
+                callback(header.value);
+    }
+
+    //! Copies into the previous representation, repeated headers keep their first value
+    std::map<std::string, std::string> toMap() const;
+
+    //! Heap bytes held by arena and index
+    std::size_t allocatedBytes() const;
+    const void *storage() const { return m_arena.data(); }
+
+private:
+    struct Entry
+    {
+        uint32_t offset;
+        uint16_t nameLength;
+        uint16_t valueLength;
+    };
+
+    AsyncHttpString m_arena;
+    std::vector<Entry, AsyncHttpCapsAllocator<Entry>> m_index;
+};
+
+//! Whitelist of header names, kept sorted so matching is a binary search without
+//! allocations. The names are not copied and have to outlive the filter (string
+//! literals usually). An empty filter matches every name.
+class AsyncHttpHeaderFilter
+{
+public:
+    AsyncHttpHeaderFilter() = default;
+    explicit AsyncHttpHeaderFilter(std::span<const std::string_view> names);
+    AsyncHttpHeaderFilter(std::initializer_list<std::string_view> names) :
+        AsyncHttpHeaderFilter{std::span<const std::string_view>{names.begin(), names.size()}}
+    {}
+
+    bool empty() const { return m_names.empty(); }
+    bool matches(std::string_view name) const;
+
+private:
+    static bool nameLess(std::string_view a, std::string_view b);
+
+    std::vector<std::string_view> m_names;
+    std::size_t m_minLength{};
+    std::size_t m_maxLength{};
+};
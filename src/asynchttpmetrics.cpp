@@ -0,0 +1,208 @@
+#include "asynchttpmetrics.h"
+
+// system includes
+#include <bit>
+#include <string_view>
+#include <iterator>
+#include <algorithm>
+
+// 3rdparty lib includes
+#include <fmt/core.h>
+
+namespace {
+constexpr auto relaxed = std::memory_order_relaxed;
+
+void writeHistogram(std::string &out, std::string_view name, const AsyncHttpMetrics::Histogram &histogram)
+{
+    fmt::format_to(std::back_inserter(out), "# TYPE {} histogram\n", name);
+
+    uint64_t cumulative{};
+    for (std::size_t i = 0; i + 1 < histogram.buckets.size(); i++)
+    {
+        cumulative += histogram.buckets[i];
+        fmt::format_to(std::back_inserter(out), "{}_bucket{{le=\"{}\"}} {}\n", name, 1u << i, cumulative);
+    }
+    cumulative += histogram.buckets.back();
+    fmt::format_to(std::back_inserter(out), "{}_bucket{{le=\"+Inf\"}} {}\n", name, cumulative);
+    fmt::format_to(std::back_inserter(out), "{}_sum {}\n{}_count {}\n", name, histogram.sumMs, name, histogram.count);
+}
+} // namespace
+
+AsyncHttpMetrics &AsyncHttpMetrics::instance()
+{
+    static AsyncHttpMetrics metrics;
+    return metrics;
+}
+
+std::size_t AsyncHttpMetrics::latencyBucket(std::chrono::milliseconds latency)
+{
+    if (latency.count() <= 1)
+        return 0;
+
+    // (2^(i-1), 2^i] ms ends up in bucket i
+    return std::min<std::size_t>(std::bit_width(uint64_t(latency.count() - 1)), LatencyBuckets - 1);
+}
+
+void AsyncHttpMetrics::record(const Sample &sample)
+{
+    const auto statusClass = sample.statusCode >= 100 && sample.statusCode < 600 ? sample.statusCode / 100 : 0;
+    m_statusClasses[statusClass].fetch_add(1, relaxed);
+
+    if (sample.result != ESP_OK)
+    {
+        bool counted{};
+        for (auto &slot : m_errors)
+        {
+            auto code = slot.code.load(relaxed);
+            // claim a free slot, another task may claim it for the same or another code meanwhile
+            if (code == ESP_OK && slot.code.compare_exchange_strong(code, sample.result, relaxed))
+                code = sample.result;
+
+            if (code == sample.result)
+            {
+                slot.count.fetch_add(1, relaxed);
+                counted = true;
+                break;
+            }
+        }
+
+        if (!counted)
+            m_otherErrors.fetch_add(1, relaxed);
+    }
+
+    if (sample.result == ESP_ERR_NO_MEM)
+        m_bufferOverflows.fetch_add(1, relaxed);
+
+    m_bytesIn.add(sample.bytesIn);
+    m_bytesOut.add(sample.bytesOut);
+
+    m_latency.record(sample.total);
+    if (sample.timeToFirstByte)
+        m_timeToFirstByte.record(*sample.timeToFirstByte);
+
+    (sample.connectionReused ? m_reuseHits : m_reuseMisses).fetch_add(1, relaxed);
+}
+
+auto AsyncHttpMetrics::snapshot() const -> Snapshot
+{
+    Snapshot snapshot;
+
+    for (std::size_t i = 0; i < m_statusClasses.size(); i++)
+        snapshot.statusClasses[i] = m_statusClasses[i].load(relaxed);
+
+    for (std::size_t i = 0; i < m_errors.size(); i++)
+        snapshot.errors[i] = {m_errors[i].code.load(relaxed), m_errors[i].count.load(relaxed)};
+
+    snapshot.otherErrors = m_otherErrors.load(relaxed);
+    snapshot.bytesIn = m_bytesIn.load();
+    snapshot.bytesOut = m_bytesOut.load();
+    snapshot.latency = m_latency.load();
+    snapshot.timeToFirstByte = m_timeToFirstByte.load();
+    snapshot.reuseHits = m_reuseHits.load(relaxed);
+    snapshot.reuseMisses = m_reuseMisses.load(relaxed);
+    snapshot.bufferOverflows = m_bufferOverflows.load(relaxed);
+
+    return snapshot;
+}
+
+void AsyncHttpMetrics::reset()
+{
+    for (auto &counter : m_statusClasses)
+        counter.store(0, relaxed);
+
+    // codes stay assigned to their slots, only the counts start over
+    for (auto &slot : m_errors)
+        slot.count.store(0, relaxed);
+
+    m_otherErrors.store(0, relaxed);
+    m_bytesIn.reset();
+    m_bytesOut.reset();
+    m_latency.reset();
+    m_timeToFirstByte.reset();
+    m_reuseHits.store(0, relaxed);
+    m_reuseMisses.store(0, relaxed);
+    m_bufferOverflows.store(0, relaxed);
+}
+
+void AsyncHttpMetrics::AtomicHistogram::record(std::chrono::milliseconds latency)
+{
+    buckets[latencyBucket(latency)].fetch_add(1, relaxed);
+    sumMs.add(std::max<int64_t>(latency.count(), 0));
+    count.fetch_add(1, relaxed);
+}
+
+auto AsyncHttpMetrics::AtomicHistogram::load() const -> Histogram
+{
+    Histogram histogram;
+    for (std::size_t i = 0; i < buckets.size(); i++)
+        histogram.buckets[i] = buckets[i].load(relaxed);
+    histogram.sumMs = sumMs.load();
+    histogram.count = count.load(relaxed);
+    return histogram;
+}
+
+void AsyncHttpMetrics::AtomicHistogram::reset()
+{
+    for (auto &bucket : buckets)
+        bucket.store(0, relaxed);
+    sumMs.reset();
+    count.store(0, relaxed);
+}
+
+void AsyncHttpMetrics::SplitCounter::add(uint64_t value)
+{
+    auto carry = uint32_t(value >> 32);
+    const auto lowValue = uint32_t(value);
+    if (const auto previous = low.fetch_add(lowValue, relaxed); uint32_t(previous + lowValue) < previous)
+        carry++;
+    if (carry)
+        high.fetch_add(carry, relaxed);
+}
+
+uint64_t AsyncHttpMetrics::SplitCounter::load() const
+{
+    uint32_t highValue, lowValue;
+    do
+    {
+        highValue = high.load(relaxed);
+        lowValue = low.load(relaxed);
+    } while (highValue != high.load(relaxed));
+    return (uint64_t(highValue) << 32) | lowValue;
+}
+
+void AsyncHttpMetrics::SplitCounter::reset()
+{
+    low.store(0, relaxed);
+    high.store(0, relaxed);
+}
+
+std::string AsyncHttpMetrics::Snapshot::toPrometheus() const
+{
+    std::string out;
+    out.reserve(2048);
+
+    out += "# TYPE async_http_requests_total counter\n";
+    constexpr const char *statusClassNames[] { "none", "1xx", "2xx", "3xx", "4xx", "5xx" };
+    for (std::size_t i = 0; i < statusClasses.size(); i++)
+        fmt::format_to(std::back_inserter(out), "async_http_requests_total{{status_class=\"{}\"}} {}\n", statusClassNames[i], statusClasses[i]);
+
+    out += "# TYPE async_http_errors_total counter\n";
+    for (const auto &[code, count] : errors)
+        if (code != ESP_OK)
+            fmt::format_to(std::back_inserter(out), "async_http_errors_total{{error=\"{}\"}} {}\n", esp_err_to_name(code), count);
+    fmt::format_to(std::back_inserter(out), "async_http_errors_total{{error=\"other\"}} {}\n", otherErrors);
+
+    fmt::format_to(std::back_inserter(out), "# TYPE async_http_received_bytes_total counter\nasync_http_received_bytes_total {}\n", bytesIn);
+    fmt::format_to(std::back_inserter(out), "# TYPE async_http_sent_bytes_total counter\nasync_http_sent_bytes_total {}\n", bytesOut);
+
+    writeHistogram(out, "async_http_request_duration_ms", latency);
+    writeHistogram(out, "async_http_time_to_first_byte_ms", timeToFirstByte);
+
+    out += "# TYPE async_http_connection_reuse_total counter\n";
+    fmt::format_to(std::back_inserter(out), "async_http_connection_reuse_total{{result=\"hit\"}} {}\n", reuseHits);
+    fmt::format_to(std::back_inserter(out), "async_http_connection_reuse_total{{result=\"miss\"}} {}\n", reuseMisses);
+
+    fmt::format_to(std::back_inserter(out), "# TYPE async_http_buffer_overflows_total counter\nasync_http_buffer_overflows_total {}\n", bufferOverflows);
+
+    return out;
+}
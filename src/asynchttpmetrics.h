@@ -0,0 +1,112 @@
+#pragma once
+
+// system includes
+#include <string>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+// esp-idf includes
+#include <esp_err.h>
+
+//! Process-wide counters fed by every AsyncHttpRequest when it finished. Recording
+//! only touches relaxed 32 bit atomics (64 bit ones take a lock on Xtensa), so it
+//! never blocks the request tasks. snapshot()
+//! copies the counters, the snapshot can be exported as Prometheus text.
+class AsyncHttpMetrics
+{
+public:
+    //! Bucket i counts latencies up to 2^i ms, the last one everything above
+    static constexpr std::size_t LatencyBuckets = 17;
+    //! Distinct error codes that are counted separately, further ones end up in otherErrors
+    static constexpr std::size_t ErrorSlots = 16;
+
+    struct Sample
+    {
+        esp_err_t result{};
+        int statusCode{};
+        std::size_t bytesIn{};
+        std::size_t bytesOut{};
+        std::chrono::milliseconds total{};
+        std::optional<std::chrono::milliseconds> timeToFirstByte;
+        bool connectionReused{};
+    };
+
+    struct Histogram
+    {
+        std::array<uint32_t, LatencyBuckets> buckets{}; // not cumulative
+        uint64_t sumMs{};
+        uint32_t count{};
+    };
+
+    struct Snapshot
+    {
+        std::array<uint32_t, 6> statusClasses{}; // index 0: no status code, 1..5: 1xx..5xx
+        std::array<std::pair<esp_err_t, uint32_t>, ErrorSlots> errors{}; // unused slots have ESP_OK
+        uint32_t otherErrors{};
+        uint64_t bytesIn{};
+        uint64_t bytesOut{};
+        Histogram latency;
+        Histogram timeToFirstByte;
+        uint32_t reuseHits{};
+        uint32_t reuseMisses{};
+        uint32_t bufferOverflows{}; // requests that failed with ESP_ERR_NO_MEM
+
+        std::string toPrometheus() const;
+    };
+
+    static AsyncHttpMetrics &instance();
+
+    static std::size_t latencyBucket(std::chrono::milliseconds latency);
+
+    void record(const Sample &sample);
+    Snapshot snapshot() const;
+    void reset();
+
+private:
+    AsyncHttpMetrics() = default;
+
+    //! 64 bit counter from two 32 bit atomics, a load racing with the carry of an add
+    //! can miss that carry once
+    struct SplitCounter
+    {
+        std::atomic<uint32_t> low{};
+        std::atomic<uint32_t> high{};
+
+        void add(uint64_t value);
+        uint64_t load() const;
+        void reset();
+    };
+
+    struct AtomicHistogram
+    {
+        std::array<std::atomic<uint32_t>, LatencyBuckets> buckets{};
+        SplitCounter sumMs;
+        std::atomic<uint32_t> count{};
+
+        void record(std::chrono::milliseconds latency);
+        Histogram load() const;
+        void reset();
+    };
+
+    struct ErrorSlot
+    {
+        std::atomic<esp_err_t> code{ESP_OK};
+        std::atomic<uint32_t> count{};
+    };
+
+    std::array<std::atomic<uint32_t>, 6> m_statusClasses{};
+    std::array<ErrorSlot, ErrorSlots> m_errors{};
+    std::atomic<uint32_t> m_otherErrors{};
+    SplitCounter m_bytesIn;
+    SplitCounter m_bytesOut;
+    AtomicHistogram m_latency;
+    AtomicHistogram m_timeToFirstByte;
+    std::atomic<uint32_t> m_reuseHits{};
+    std::atomic<uint32_t> m_reuseMisses{};
+    std::atomic<uint32_t> m_bufferOverflows{};
+};
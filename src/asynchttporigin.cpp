@@ -0,0 +1,115 @@
+#include "asynchttporigin.h"
+
+// system includes
+#include <algorithm>
+#include <charconv>
+#include <functional>
+#include <cctype>
+
+namespace {
+std::size_t hashMaterial(std::string_view material)
+{
+    if (material.empty())
+        return 0;
+
+    // mix in the size, pem blobs tend to share long common prefixes
+    return std::hash<std::string_view>{}(material) ^ (material.size() * 0x9e3779b9u);
+}
+
+std::string toLower(std::string_view str)
+{
+    std::string result{str};
+    std::transform(std::begin(result), std::end(result), std::begin(result), [](unsigned char c){ return std::tolower(c); });
+    return result;
+}
+} // namespace
+
+AsyncHttpOrigin::Material AsyncHttpOrigin::Material::of(std::string_view material)
+{
+    if (material.empty())
+        return {};
+
+    return Material {
+        .data = material.data(),
+        .size = material.size(),
+        .hash = hashMaterial(material),
+    };
+}
+
+std::optional<AsyncHttpOrigin> AsyncHttpOrigin::parse(std::string_view url,
+                                                      std::string_view serverCert,
+                                                      const std::optional<cpputils::ClientAuth> &clientAuth)
+{
+    AsyncHttpOrigin origin {
+        .serverCert = Material::of(serverCert),
+    };
+
+    if (clientAuth)
+    {
+        origin.clientKey = Material::of(clientAuth->clientKey);
+        origin.clientCert = Material::of(clientAuth->clientCert);
+    }
+
+    return origin.withUrl(url);
+}
+
+std::optional<AsyncHttpOrigin> AsyncHttpOrigin::withUrl(std::string_view url) const
+{
+    AsyncHttpOrigin origin {
+        .serverCert = serverCert,
+        .clientKey = clientKey,
+        .clientCert = clientCert,
+    };
+
+    const auto schemeEnd = url.find("://");
+    if (schemeEnd == std::string_view::npos || schemeEnd == 0)
+        return std::nullopt;
+
+    origin.scheme = toLower(url.substr(0, schemeEnd));
+
+    auto authority = url.substr(schemeEnd + 3);
+    authority = authority.substr(0, authority.find_first_of("/?#"));
+
+    if (const auto userinfoEnd = authority.rfind('@'); userinfoEnd != std::string_view::npos)
+    {
+        origin.credentialsHash = hashMaterial(authority.substr(0, userinfoEnd));
+        authority.remove_prefix(userinfoEnd + 1);
+    }
+
+    std::string_view port;
+    if (authority.starts_with('['))
+    {
+        // ipv6 literal
+        const auto hostEnd = authority.find(']');
+        if (hostEnd == std::string_view::npos)
+            return std::nullopt;
+        origin.host = toLower(authority.substr(0, hostEnd + 1));
+        if (const auto rest = authority.substr(hostEnd + 1); rest.starts_with(':'))
+            port = rest.substr(1);
+    }
+    else if (const auto portStart = authority.rfind(':'); portStart != std::string_view::npos)
+    {
+        origin.host = toLower(authority.substr(0, portStart));
+        port = authority.substr(portStart + 1);
+    }
+    else
+        origin.host = toLower(authority);
+
+    if (origin.host.empty())
+        return std::nullopt;
+
+    if (!port.empty())
+    {
+        if (const auto [ptr, ec] = std::from_chars(port.data(), port.data() + port.size(), origin.port);
+            ec != std::errc{} || ptr != port.data() + port.size())
+            return std::nullopt;
+    }
+    else if (origin.scheme == "https")
+        origin.port = 443;
+    else if (origin.scheme == "http")
+        origin.port = 80;
+    else
+        return std::nullopt;
+
+    return origin;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+// system includes
+#include <string>
+#include <string_view>
+#include <optional>
+#include <cstdint>
+
+// 3rdparty lib includes
+#include <clientauth.h>
+
+//! Identifies everything a connection of an http client depends on, two requests
+//! with equal origins can share the same (kept-alive) connection.
+struct AsyncHttpOrigin
+{
+    //! A pem blob the client was configured with. The client keeps pointing to the blob
+    //! and reads it again on every (re)connect, so equal contents at another address are
+    //! not enough to share it. The hash catches a blob replaced at the same address.
+    struct Material
+    {
+        const char *data{};
+        std::size_t size{};
+        std::size_t hash{};
+
+        bool operator==(const Material &other) const = default;
+
+        static Material of(std::string_view material);
+    };
+
+    std::string scheme; // lower case
+    std::string host; // lower case
+    uint16_t port{};
+    std::size_t credentialsHash{}; // userinfo of the url
+    Material serverCert;
+    Material clientKey;
+    Material clientCert;
+
+    bool operator==(const AsyncHttpOrigin &other) const = default;
+
+    static std::optional<AsyncHttpOrigin> parse(std::string_view url,
+                                                std::string_view serverCert = {},
+                                                const std::optional<cpputils::ClientAuth> &clientAuth = {});
+
+    //! Keeps the tls material of this origin, but takes scheme, host, port and credentials from url
+    std::optional<AsyncHttpOrigin> withUrl(std::string_view url) const;
+};
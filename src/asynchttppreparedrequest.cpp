@@ -0,0 +1,68 @@
+#include "asynchttppreparedrequest.h"
+
+#include "sdkconfig.h"
+#define LOG_LOCAL_LEVEL CONFIG_LOG_LOCAL_LEVEL_ASYNC_HTTP
+
+// system includes
+#include <atomic>
+
+// esp-idf includes
+#include <esp_log.h>
+
+// 3rdparty lib includes
+#include <fmt/core.h>
+
+namespace {
+constexpr const char * const TAG = "ASYNC_HTTP";
+
+std::atomic<uint32_t> nextId{1};
+} // namespace
+
+auto AsyncHttpPreparedRequest::create(std::string_view url,
+                                      esp_http_client_method_t method,
+                                      const std::map<std::string, std::string> &requestHeaders,
+                                      int timeout_ms,
+                                      std::string_view serverCert,
+                                      const std::optional<cpputils::ClientAuth> &clientAuth) -> std::expected<AsyncHttpPreparedRequest, std::string>
+{
+    auto origin = AsyncHttpOrigin::parse(url, serverCert, clientAuth);
+    if (!origin)
+    {
+        auto msg = fmt::format("invalid url for prepared request ({})", url);
+        ESP_LOGW(TAG, "%.*s", msg.size(), msg.data());
+        return std::unexpected(std::move(msg));
+    }
+
+    AsyncHttpPreparedRequest prepared;
+    prepared.m_id = nextId++;
+    prepared.m_url = url;
+    prepared.m_method = method;
+    prepared.m_timeout_ms = timeout_ms;
+    prepared.m_serverCert = serverCert;
+    prepared.m_clientAuth = clientAuth;
+    prepared.m_origin = std::move(*origin);
+
+    std::size_t blockSize{};
+    for (const auto &[key, value] : requestHeaders)
+        blockSize += key.size() + 1 + value.size() + 1;
+
+    // sized up front, the views must not be invalidated by a reallocation
+    prepared.m_headerBlock.reserve(blockSize);
+    prepared.m_headers.reserve(requestHeaders.size());
+
+    const auto appendTerminated = [&](std::string_view str){
+        const auto begin = prepared.m_headerBlock.data() + prepared.m_headerBlock.size();
+        prepared.m_headerBlock.insert(std::end(prepared.m_headerBlock), std::begin(str), std::end(str));
+        prepared.m_headerBlock.push_back('\0');
+        return std::string_view{begin, str.size()};
+    };
+
+    for (const auto &[key, value] : requestHeaders)
+    {
+        const auto keyView = appendTerminated(key);
+        const auto valueView = appendTerminated(value);
+        prepared.m_headers.emplace_back(keyView, valueView);
+    }
+
+    return prepared;
+}
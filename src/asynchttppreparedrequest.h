@@ -0,0 +1,66 @@
+#pragma once
+
+// system includes
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <span>
+#include <optional>
+#include <expected>
+#include <cstdint>
+
+// esp-idf includes
+#include <esp_http_client.h>
+
+// 3rdparty lib includes
+#include <clientauth.h>
+
+// local includes
+#include "asynchttporigin.h"
+#include "asynchttpheaders.h"
+
+//! Template for a request that is issued over and over with the same url, method,
+//! headers and tls material. The url is validated and parsed once, the headers are
+//! serialized into one block and the tls material is pinned. AsyncHttpRequest::start()
+//! with a prepared request only swaps the body when its client was set up from the
+//! same template before.
+//! serverCert and clientAuth are not copied and have to outlive every client using them.
+class AsyncHttpPreparedRequest
+{
+public:
+    static std::expected<AsyncHttpPreparedRequest, std::string> create(std::string_view url,
+                                                                       esp_http_client_method_t method = HTTP_METHOD_GET,
+                                                                       const std::map<std::string, std::string> &requestHeaders = {},
+                                                                       int timeout_ms = 0,
+                                                                       std::string_view serverCert = {},
+                                                                       const std::optional<cpputils::ClientAuth> &clientAuth = {});
+
+    AsyncHttpPreparedRequest(AsyncHttpPreparedRequest &&other) = default;
+    AsyncHttpPreparedRequest &operator=(AsyncHttpPreparedRequest &&other) = default;
+
+    //! Unique per template, a client configured from it remembers the id
+    uint32_t id() const { return m_id; }
+
+    const std::string &url() const { return m_url; }
+    esp_http_client_method_t method() const { return m_method; }
+    int timeout_ms() const { return m_timeout_ms; }
+    std::string_view serverCert() const { return m_serverCert; }
+    const std::optional<cpputils::ClientAuth> &clientAuth() const { return m_clientAuth; }
+    const AsyncHttpOrigin &origin() const { return m_origin; }
+    //! Null-terminated views into the header block
+    std::span<const AsyncHttpHeaderView> headers() const { return m_headers; }
+
+private:
+    AsyncHttpPreparedRequest() = default;
+
+    uint32_t m_id{};
+    std::string m_url;
+    esp_http_client_method_t m_method{HTTP_METHOD_GET};
+    int m_timeout_ms{};
+    std::string_view m_serverCert;
+    std::optional<cpputils::ClientAuth> m_clientAuth;
+    AsyncHttpOrigin m_origin;
+    std::vector<char> m_headerBlock; // "name\0value\0" pairs, moving keeps the views valid
+    std::vector<AsyncHttpHeaderView> m_headers;
+};
@@ -9,9 +9,14 @@
 #include <cstring>
 #include <assert.h>
 #include <algorithm>
+#include <coroutine>
 
 // esp-idf includes
 #include <esp_log.h>
+#ifndef CONFIG_IDF_TARGET_LINUX
+#include <esp_memory_utils.h>
+#endif
+#include <esp_random.h>
 
 // 3rdparty lib includes
 #include <fmt/core.h>
@@ -20,8 +25,16 @@
 #include <taskutils.h>
 #include <tickchrono.h>
 
+// local includes
+#include "asynchttpworker.h"
+#include "asynchttporigin.h"
+#include "asynchttpconnectionpool.h"
+#include "asynchttpmetrics.h"
+
 using namespace std::chrono_literals;
 
+ESP_EVENT_DEFINE_BASE(ASYNC_HTTP_EVENT);
+
 namespace {
 constexpr const char * const TAG = "ASYNC_HTTP";
 
@@ -32,6 +45,54 @@ constexpr int REQUEST_FINISHED_BIT = BIT3;
 constexpr int END_TASK_BIT = BIT4;
 constexpr int TASK_ENDED_BIT = BIT5;
 constexpr int ABORT_REQUEST_BIT = BIT6;
+constexpr int SCHEDULED_BIT = BIT7;
+
+constexpr std::chrono::milliseconds POLL_INTERVAL_MIN{CONFIG_ASYNC_HTTP_POLL_INTERVAL_MIN_MS};
+constexpr std::chrono::milliseconds POLL_INTERVAL_MAX{CONFIG_ASYNC_HTTP_POLL_INTERVAL_MAX_MS};
+
+// what esp_http_client uses when the config leaves timeout_ms at 0
+constexpr int DEFAULT_TIMEOUT_MS = 5000;
+
+constexpr uint32_t FNV_OFFSET_BASIS = 2166136261u;
+constexpr uint32_t FNV_PRIME = 16777619u;
+
+// interactive requests between beginRequest() and finishRequest(), pausable bulk requests wait for 0
+std::atomic<int> interactiveRequests{};
+
+// may be sent twice, a stale kept-alive connection is only retried for these
+bool idempotent(esp_http_client_method_t method)
+{
+    return cpputils::is_in(method, HTTP_METHOD_GET, HTTP_METHOD_HEAD, HTTP_METHOD_PUT, HTTP_METHOD_DELETE, HTTP_METHOD_OPTIONS);
+}
+
+// what perform() returns when the peer already closed the connection, timeouts are not among them
+bool connectionLost(esp_err_t result)
+{
+    return cpputils::is_in(result, ESP_ERR_HTTP_CONNECTION_CLOSED, ESP_ERR_HTTP_WRITE_DATA, ESP_ERR_HTTP_FETCH_HEADER);
+}
+
+void accountMemory(AsyncHttpRequest::MemoryUsage &usage, const void *ptr, std::size_t size)
+{
+    if (!ptr || !size)
+        return;
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+    // the host has no external ram
+    usage.internal += size;
+#else
+    (esp_ptr_external_ram(ptr) ? usage.external : usage.internal) += size;
+#endif
+}
+
+template<typename String>
+void accountMemory(AsyncHttpRequest::MemoryUsage &usage, const String &str)
+{
+    // short strings live inside the object itself
+    if (const auto data = str.data(); data >= (const char *)&str && data < (const char *)(&str + 1))
+        return;
+
+    accountMemory(usage, str.data(), str.capacity() + 1);
+}
 } // namespace
 
 AsyncHttpRequest::AsyncHttpRequest(const char *taskName, espcpputils::CoreAffinity coreAffinity, uint32_t taskSize) :
@@ -42,13 +103,64 @@ AsyncHttpRequest::AsyncHttpRequest(const char *taskName, espcpputils::CoreAffini
     assert(m_eventGroup.handle);
 }
 
+AsyncHttpRequest::AsyncHttpRequest(std::span<StackType_t> taskStack, StaticTask_t &taskBuffer,
+                                   const char *taskName, espcpputils::CoreAffinity coreAffinity) :
+    m_taskStack{taskStack},
+    m_taskBuffer{&taskBuffer},
+    m_taskName{taskName},
+    m_taskSize{uint32_t(taskStack.size())},
+    m_coreAffinity{coreAffinity}
+{
+    assert(m_eventGroup.handle);
+}
+
+AsyncHttpRequest::AsyncHttpRequest(AsyncHttpWorker &worker, const char *name) :
+    m_worker{&worker},
+    m_taskName{name},
+    m_taskSize{0},
+    m_coreAffinity{espcpputils::CoreAffinity::Both}
+{
+    assert(m_eventGroup.handle);
+
+    m_worker->attach(*this);
+}
+
+AsyncHttpRequest::AsyncHttpRequest(Polled, const char *name) :
+    m_polled{true},
+    m_taskName{name},
+    m_taskSize{0},
+    m_coreAffinity{espcpputils::CoreAffinity::Both}
+{
+    assert(m_eventGroup.handle);
+}
+
 AsyncHttpRequest::~AsyncHttpRequest()
 {
-    endTask();
+    if (m_worker)
+        m_worker->detach(*this);
+    else
+        endTask();
+
+    if (!inProgress())
+        releaseClient();
 }
 
 std::expected<void, std::string> AsyncHttpRequest::startTask()
 {
+    if (m_worker)
+    {
+        constexpr auto msg = "http request is driven by a worker";
+        ESP_LOGW(TAG, "%s", msg);
+        return std::unexpected(msg);
+    }
+
+    if (m_polled)
+    {
+        constexpr auto msg = "http request is polled";
+        ESP_LOGW(TAG, "%s", msg);
+        return std::unexpected(msg);
+    }
+
     if (m_taskHandle)
     {
         constexpr auto msg = "http task handle is not null";
@@ -65,8 +177,21 @@ std::expected<void, std::string> AsyncHttpRequest::startTask()
 
     m_eventGroup.clearBits(TASK_RUNNING_BIT | START_REQUEST_BIT | REQUEST_RUNNING_BIT | REQUEST_FINISHED_BIT | END_TASK_BIT | TASK_ENDED_BIT | ABORT_REQUEST_BIT);
 
-    if (auto result = espcpputils::createTask(requestTask, m_taskName, m_taskSize, this, 10, &m_taskHandle, m_coreAffinity);
-        result != pdPASS)
+    if (m_taskStack.data())
+    {
+        BaseType_t coreId;
+        switch (m_coreAffinity)
+        {
+        case espcpputils::CoreAffinity::Core0: coreId = 0; break;
+        case espcpputils::CoreAffinity::Core1: coreId = 1; break;
+        default: coreId = tskNO_AFFINITY;
+        }
+
+        m_taskHandle = xTaskCreateStaticPinnedToCore(requestTask, m_taskName, m_taskStack.size(), this, m_taskPriority,
+                                                     m_taskStack.data(), m_taskBuffer, coreId);
+    }
+    else if (auto result = espcpputils::createTask(requestTask, m_taskName, m_taskSize, this, m_taskPriority, &m_taskHandle, m_coreAffinity);
+             result != pdPASS)
     {
         auto msg = fmt::format("failed creating http task {}", result);
         ESP_LOGE(TAG, "%.*s", msg.size(), msg.data());
@@ -111,18 +236,26 @@ std::expected<void, std::string> AsyncHttpRequest::endTask()
     m_eventGroup.setBits(END_TASK_BIT);
 
     if (const auto bits = m_eventGroup.waitBits(TASK_ENDED_BIT, true, false, std::chrono::ceil<espcpputils::ticks>(1s).count());
-        bits & TASK_ENDED_BIT)
+        !(bits & TASK_ENDED_BIT))
     {
-        ESP_LOGI(TAG, "http task %s ended", m_taskName);
-        return {};
+        ESP_LOGW(TAG, "http task %s TASK_ENDED_BIT bit not yet set...", m_taskName);
+
+        while (true)
+            if (const auto bits = m_eventGroup.waitBits(TASK_ENDED_BIT, true, false, portMAX_DELAY);
+                bits & TASK_ENDED_BIT)
+                break;
     }
 
-    ESP_LOGW(TAG, "http task %s TASK_ENDED_BIT bit not yet set...", m_taskName);
+    if (m_taskStack.data() && m_taskHandle)
+    {
+        // the task suspends itself as its very last step, deleting it from here releases
+        // the caller's stack and tcb right away instead of once the idle task cleaned up
+        while (eTaskGetState(m_taskHandle) != eSuspended)
+            espcpputils::delay(1ms);
 
-    while (true)
-        if (const auto bits = m_eventGroup.waitBits(TASK_ENDED_BIT, true, false, portMAX_DELAY);
-            bits & TASK_ENDED_BIT)
-            break;
+        vTaskDelete(m_taskHandle);
+        m_taskHandle = NULL;
+    }
 
     ESP_LOGI(TAG, "http task %s ended", m_taskName);
 
@@ -131,6 +264,12 @@ std::expected<void, std::string> AsyncHttpRequest::endTask()
 
 bool AsyncHttpRequest::taskRunning() const
 {
+    if (m_worker)
+        return m_worker->tasksRunning();
+
+    if (m_polled)
+        return false;
+
     if (const auto bits = m_eventGroup.getBits();
         bits & TASK_RUNNING_BIT)
         return true;
@@ -142,6 +281,15 @@ std::expected<void, std::string> AsyncHttpRequest::createClient(std::string_view
                                                                 int timeout_ms,
                                                                 std::string_view serverCert,
                                                                 const std::optional<cpputils::ClientAuth> &clientAuth)
+{
+    return createClient(AsyncHttpOrigin::parse(url, serverCert, clientAuth), url, method, timeout_ms, serverCert, clientAuth);
+}
+
+std::expected<void, std::string> AsyncHttpRequest::createClient(std::optional<AsyncHttpOrigin> &&origin,
+                                                                std::string_view url, esp_http_client_method_t method,
+                                                                int timeout_ms,
+                                                                std::string_view serverCert,
+                                                                const std::optional<cpputils::ClientAuth> &clientAuth)
 {
     if (m_client)
     {
@@ -150,6 +298,30 @@ std::expected<void, std::string> AsyncHttpRequest::createClient(std::string_view
         return std::unexpected(msg);
     }
 
+    m_preparedId = 0;
+    m_requestBodySize = 0;
+
+    if (m_usePool && origin)
+        if (auto pooled = AsyncHttpConnectionPool::instance().checkout(*origin))
+        {
+            m_client = std::move(pooled->client);
+            esp_http_client_set_user_data(m_client.handle, this);
+            m_clientOrigin = std::move(origin);
+            m_connected = pooled->connected;
+            m_clientHasSession = pooled->hasSession;
+            m_requestHeaderKeys.clear();
+
+            if (auto result = configureClient(url, method, timeout_ms); !result)
+            {
+                m_client = {};
+                return std::unexpected(std::move(result).error());
+            }
+
+            ESP_LOGD(TAG, "took http client %s from the connection pool", m_taskName);
+
+            return {};
+        }
+
     esp_http_client_config_t config {
         .url = url.data(),
         .user_agent = "Browsinator 3000 (ESP32-9000X Super Fun Edition) Quantum Entangled Gecko/42.0 LOLMobile Safari",
@@ -161,6 +333,11 @@ std::expected<void, std::string> AsyncHttpRequest::createClient(std::string_view
         .is_async = true,
     };
 
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    // lets the transport resume the tls session when this client reconnects
+    config.save_client_session = true;
+#endif
+
     if (!serverCert.empty())
     {
         config.cert_pem = serverCert.data();
@@ -184,6 +361,11 @@ std::expected<void, std::string> AsyncHttpRequest::createClient(std::string_view
         return std::unexpected(std::move(msg));
     }
 
+    m_clientOrigin = std::move(origin);
+    m_connected = false;
+    m_clientHasSession = false;
+    m_requestHeaderKeys.clear();
+
     ESP_LOGD(TAG, "created http client %s", m_taskName);
 
     return {};
@@ -201,7 +383,7 @@ std::expected<void, std::string> AsyncHttpRequest::deleteClient()
         return std::unexpected(msg);
     }
 
-    m_client = {};
+    releaseClient();
 
     return {};
 }
@@ -218,50 +400,294 @@ std::expected<void, std::string> AsyncHttpRequest::start(std::string_view url,
                                                          std::string_view serverCert,
                                                          const std::optional<cpputils::ClientAuth> &clientAuth)
 {
-    if (!m_taskHandle)
+    auto lock = lockStart();
+    if (!lock)
+        return std::unexpected(std::move(lock).error());
+
+    if (auto queued = queueIfBusy({}, url, method, requestHeaders, requestBody, {}, timeout_ms, serverCert, clientAuth))
+        return *std::move(queued);
+
+    return startRequest({}, url, method, requestHeaders, std::move(requestBody), {}, timeout_ms, serverCert, clientAuth);
+}
+
+std::expected<void, std::string> AsyncHttpRequest::startInto(std::span<char> responseBuffer,
+                                                             std::string_view url,
+                                                             esp_http_client_method_t method,
+                                                             const std::map<std::string, std::string> &requestHeaders,
+                                                             std::string &&requestBody, int timeout_ms,
+                                                             std::string_view serverCert,
+                                                             const std::optional<cpputils::ClientAuth> &clientAuth)
+{
+    auto lock = lockStart();
+    if (!lock)
+        return std::unexpected(std::move(lock).error());
+
+    if (auto queued = queueIfBusy(responseBuffer, url, method, requestHeaders, requestBody, {}, timeout_ms, serverCert, clientAuth))
+        return *std::move(queued);
+
+    return startRequest(responseBuffer, url, method, requestHeaders, std::move(requestBody), {}, timeout_ms, serverCert, clientAuth);
+}
+
+std::expected<void, std::string> AsyncHttpRequest::startView(std::string_view url,
+                                                             esp_http_client_method_t method,
+                                                             std::span<const HeaderView> requestHeaders,
+                                                             std::span<const std::byte> requestBody, int timeout_ms,
+                                                             std::string_view serverCert,
+                                                             const std::optional<cpputils::ClientAuth> &clientAuth,
+                                                             std::span<char> responseBuffer)
+{
+    auto lock = lockStart();
+    if (!lock)
+        return std::unexpected(std::move(lock).error());
+
+    std::string noBody;
+    if (auto queued = queueIfBusy(responseBuffer, url, method, requestHeaders, noBody, requestBody, timeout_ms, serverCert, clientAuth))
+        return *std::move(queued);
+
+    return startRequest(responseBuffer, url, method, requestHeaders, {}, requestBody, timeout_ms, serverCert, clientAuth);
+}
+
+std::expected<void, std::string> AsyncHttpRequest::startNow(std::string_view url,
+                                                            esp_http_client_method_t method,
+                                                            const std::map<std::string, std::string> &requestHeaders,
+                                                            std::string &&requestBody, int timeout_ms,
+                                                            std::string_view serverCert,
+                                                            const std::optional<cpputils::ClientAuth> &clientAuth)
+{
+    auto lock = lockStart();
+    if (!lock)
+        return std::unexpected(std::move(lock).error());
+
+    return startRequest({}, url, method, requestHeaders, std::move(requestBody), {}, timeout_ms, serverCert, clientAuth);
+}
+
+std::expected<void, std::string> AsyncHttpRequest::startNow(const AsyncHttpPreparedRequest &prepared, std::string &&requestBody)
+{
+    auto lock = lockStart();
+    if (!lock)
+        return std::unexpected(std::move(lock).error());
+
+    return startPrepared({}, prepared, std::move(requestBody), {});
+}
+
+auto AsyncHttpRequest::lockStart() -> std::expected<std::unique_lock<std::mutex>, std::string>
+{
+    if (auto result = ensureTask(); !result)
+        return std::unexpected(std::move(result).error());
+
+    // held until submitRequest(), a scheduled cycle cannot be claimed meanwhile
+    return std::unique_lock{m_startMutex};
+}
+
+auto AsyncHttpRequest::queueIfBusy(std::span<char> responseBuffer,
+                                   std::string_view url,
+                                   esp_http_client_method_t method,
+                                   const RequestHeaders &requestHeaders,
+                                   std::string &requestBody,
+                                   std::span<const std::byte> requestBodyView, int timeout_ms,
+                                   std::string_view serverCert,
+                                   const std::optional<cpputils::ClientAuth> &clientAuth) -> std::optional<std::expected<void, std::string>>
+{
+    std::lock_guard lock{m_queueMutex};
+
+    // requests already waiting go first
+    if (!busy() && !m_queueStarting && m_queue.empty())
+        return std::nullopt;
+
+    if (m_queue.size() >= m_queueCapacity)
     {
-        if (auto result = startTask(); !result)
-            return std::unexpected(std::move(result).error());
+        m_queueStats.rejected++;
+        const auto msg = m_queueCapacity ? "request queue full" : "another request still in progress";
+        ESP_LOGW(TAG, "%s", msg);
+        return std::unexpected(msg);
     }
 
-    if (inProgress())
+    QueuedRequest queued {
+        .responseBuffer = responseBuffer,
+        .url = std::string{url},
+        .method = method,
+        .requestBody = std::move(requestBody),
+        .requestBodyView = requestBodyView,
+        .timeout_ms = timeout_ms,
+        .serverCert = serverCert,
+        .clientAuth = clientAuth,
+        .queuedAt = espchrono::millis_clock::now(),
+        .priority = m_priority,
+        .deadline = m_deadline,
+    };
+    requestHeaders.forEach([&](std::string_view key, std::string_view value) -> std::expected<void, std::string> {
+        queued.requestHeaders.emplace_back(key, value);
+        return {};
+    });
+
+    m_queue.push_back(std::move(queued));
+
+    m_queueStats.enqueued++;
+    m_queueStats.maxDepth = std::max(m_queueStats.maxDepth, m_queue.size());
+
+    ESP_LOGD(TAG, "%s queued request (depth %zu)", m_taskName, m_queue.size());
+
+    return std::expected<void, std::string>{};
+}
+
+void AsyncHttpRequest::startQueuedRequest()
+{
+    while (true)
+    {
+        std::optional<QueuedRequest> queued;
+
+        {
+            std::lock_guard lock{m_queueMutex};
+            if (inProgress())
+                return;
+
+            const auto now = espchrono::millis_clock::now();
+            const auto expired = std::remove_if(std::begin(m_queue), std::end(m_queue), [&](const QueuedRequest &request){
+                return request.deadline && now > *request.deadline;
+            });
+            if (const auto count = std::distance(expired, std::end(m_queue)))
+            {
+                ESP_LOGW(TAG, "%s dropping %zu queued requests past their deadline", m_taskName, std::size_t(count));
+                m_queueStats.expired += count;
+                m_queue.erase(expired, std::end(m_queue));
+            }
+
+            if (m_queue.empty())
+                return;
+
+            // highest priority first, earliest deadline first within a priority, otherwise fifo
+            const auto next = std::min_element(std::begin(m_queue), std::end(m_queue), [](const QueuedRequest &a, const QueuedRequest &b){
+                if (a.priority != b.priority)
+                    return a.priority > b.priority;
+                if (a.deadline && b.deadline)
+                    return *a.deadline < *b.deadline;
+                return a.deadline && !b.deadline;
+            });
+
+            queued = std::move(*next);
+            m_queue.erase(next);
+            m_queueStarting = true;
+
+            const std::chrono::milliseconds waited = now - queued->queuedAt;
+            m_queueStats.dequeued++;
+            m_queueStats.totalWait += waited;
+            m_queueStats.maxWait = std::max(m_queueStats.maxWait, waited);
+        }
+
+        std::vector<HeaderView> requestHeaders;
+        requestHeaders.reserve(queued->requestHeaders.size());
+        for (const auto &[key, value] : queued->requestHeaders)
+            requestHeaders.emplace_back(key, value);
+
+        std::expected<void, std::string> result;
+        if (auto lock = lockStart(); !lock)
+            result = std::unexpected(std::move(lock).error());
+        else
+            result = startRequest(queued->responseBuffer, queued->url, queued->method, std::span<const HeaderView>{requestHeaders},
+                                  std::move(queued->requestBody), queued->requestBodyView, queued->timeout_ms,
+                                  queued->serverCert, queued->clientAuth);
+
+        {
+            std::lock_guard lock{m_queueMutex};
+            m_queueStarting = false;
+        }
+
+        if (result)
+        {
+            // submitRequest() took the current settings of the instance
+            m_activePriority = queued->priority;
+            m_activeDeadline = queued->deadline;
+            return;
+        }
+
+        ESP_LOGW(TAG, "%s dropping queued request: %.*s", m_taskName, result.error().size(), result.error().data());
+    }
+}
+
+std::size_t AsyncHttpRequest::queueCapacity() const
+{
+    std::lock_guard lock{m_queueMutex};
+    return m_queueCapacity;
+}
+
+void AsyncHttpRequest::setQueueCapacity(std::size_t queueCapacity)
+{
+    std::lock_guard lock{m_queueMutex};
+    m_queueCapacity = queueCapacity;
+}
+
+std::size_t AsyncHttpRequest::queueDepth() const
+{
+    std::lock_guard lock{m_queueMutex};
+    return m_queue.size();
+}
+
+void AsyncHttpRequest::clearQueue()
+{
+    std::lock_guard lock{m_queueMutex};
+    m_queue.clear();
+}
+
+auto AsyncHttpRequest::queueStats() const -> QueueStats
+{
+    std::lock_guard lock{m_queueMutex};
+    auto stats = m_queueStats;
+    stats.depth = m_queue.size();
+    return stats;
+}
+
+std::expected<void, std::string> AsyncHttpRequest::startRequest(std::span<char> responseBuffer,
+                                                                std::string_view url,
+                                                                esp_http_client_method_t method,
+                                                                const RequestHeaders &requestHeaders,
+                                                                std::string &&requestBody,
+                                                                std::span<const std::byte> requestBodyView, int timeout_ms,
+                                                                std::string_view serverCert,
+                                                                const std::optional<cpputils::ClientAuth> &clientAuth)
+{
+    if (busy())
     {
         constexpr auto msg = "another request still in progress";
         ESP_LOGW(TAG, "%s", msg);
         return std::unexpected(msg);
     }
 
+    bool reuse{};
     if (m_client)
     {
-        ESP_LOGW(TAG, "old http client still constructed, destructing now");
-        m_client = {};
+        if (m_keepAlive && m_clientOrigin && m_clientOrigin == AsyncHttpOrigin::parse(url, serverCert, clientAuth))
+            reuse = true;
+        else
+        {
+            ESP_LOGD(TAG, "old http client for another origin still constructed, releasing now");
+            releaseClient();
+        }
     }
 
-    if (auto result = createClient(url, method, timeout_ms, serverCert, clientAuth); !result)
+    if (reuse)
+    {
+        if (auto result = reuseClient(url, method, timeout_ms, requestHeaders); !result)
+            return std::unexpected(std::move(result).error());
+    }
+    else if (auto result = createClient(url, method, timeout_ms, serverCert, clientAuth); !result)
         return std::unexpected(std::move(result).error());
 
-    m_requestBody = std::move(requestBody);
-    if (!m_requestBody.empty())
-        if (const auto result = m_client.set_post_field(m_requestBody); result != ESP_OK)
-        {
-            auto msg = fmt::format("m_client.set_post_field() failed with {}", esp_err_to_name(result));
-            ESP_LOGE(TAG, "%.*s", msg.size(), msg.data());
-            return std::unexpected(std::move(msg));
-        }
-
-    for (auto iter = std::cbegin(requestHeaders); iter != std::cend(requestHeaders); iter++)
-        if (const auto result = m_client.set_header(iter->first, iter->second); result != ESP_OK)
-        {
-            auto msg = fmt::format("m_client.set_header() failed: {} ({} {})", esp_err_to_name(result), iter->first, iter->second);
-            ESP_LOGW(TAG, "%.*s", msg.size(), msg.data());
-            return std::unexpected(std::move(msg));
-        }
+    storeRequestBody(requestBody);
+    const auto body = requestBodyView.data() ? std::string_view{(const char *)requestBodyView.data(), requestBodyView.size()} : std::string_view{m_requestBody};
+    if (!body.empty() || reuse)
+        if (auto result = setRequestBody(body); !result)
+            return std::unexpected(std::move(result).error());
 
+    if (auto result = setRequestHeaders(requestHeaders); !result)
+        return std::unexpected(std::move(result).error());
 
     m_buf.clear();
+    m_segments.clear();
+    m_responseBuffer = responseBuffer;
+    m_method = method;
+    m_responseSize = 0;
 
-    clearFinished();
-    m_eventGroup.setBits(START_REQUEST_BIT);
+    submitRequest();
 
     return {};
 }
@@ -271,13 +697,42 @@ std::expected<void, std::string> AsyncHttpRequest::retry(std::optional<std::stri
                                                          const std::map<std::string, std::string> &requestHeaders,
                                                          std::optional<std::string> &&requestBody, std::optional<int> timeout_ms)
 {
-    if (!m_taskHandle)
-    {
-        if (auto result = startTask(); !result)
-            return std::unexpected(std::move(result).error());
-    }
+    return retryRequest({}, url, method, requestHeaders, std::move(requestBody), std::nullopt, timeout_ms);
+}
 
-    if (inProgress())
+std::expected<void, std::string> AsyncHttpRequest::retryInto(std::span<char> responseBuffer,
+                                                             std::optional<std::string_view> url,
+                                                             std::optional<esp_http_client_method_t> method,
+                                                             const std::map<std::string, std::string> &requestHeaders,
+                                                             std::optional<std::string> &&requestBody, std::optional<int> timeout_ms)
+{
+    return retryRequest(responseBuffer, url, method, requestHeaders, std::move(requestBody), std::nullopt, timeout_ms);
+}
+
+std::expected<void, std::string> AsyncHttpRequest::retryView(std::optional<std::string_view> url,
+                                                             std::optional<esp_http_client_method_t> method,
+                                                             std::span<const HeaderView> requestHeaders,
+                                                             std::optional<std::span<const std::byte>> requestBody,
+                                                             std::optional<int> timeout_ms,
+                                                             std::span<char> responseBuffer)
+{
+    return retryRequest(responseBuffer, url, method, requestHeaders, std::nullopt, requestBody, timeout_ms);
+}
+
+std::expected<void, std::string> AsyncHttpRequest::retryRequest(std::span<char> responseBuffer,
+                                                                std::optional<std::string_view> url,
+                                                                std::optional<esp_http_client_method_t> method,
+                                                                const RequestHeaders &requestHeaders,
+                                                                std::optional<std::string> &&requestBody,
+                                                                std::optional<std::span<const std::byte>> requestBodyView,
+                                                                std::optional<int> timeout_ms)
+{
+    // held until submitRequest(), a scheduled cycle cannot be claimed meanwhile
+    auto lock = lockStart();
+    if (!lock)
+        return std::unexpected(std::move(lock).error());
+
+    if (busy())
     {
         constexpr auto msg = "another request still in progress";
         ESP_LOGW(TAG, "%s", msg);
@@ -291,7 +746,10 @@ std::expected<void, std::string> AsyncHttpRequest::retry(std::optional<std::stri
         return std::unexpected(msg);
     }
 
+    m_preparedId = 0;
+
     if (url)
+    {
         if (const auto result = m_client.set_url(*url); result != ESP_OK)
         {
             auto msg = fmt::format("m_client.set_url() failed: {} ({})", esp_err_to_name(result), *url);
@@ -299,6 +757,10 @@ std::expected<void, std::string> AsyncHttpRequest::retry(std::optional<std::stri
             return std::unexpected(std::move(msg));
         }
 
+        if (m_clientOrigin)
+            m_clientOrigin = m_clientOrigin->withUrl(*url);
+    }
+
     if (method)
         if (const auto result = m_client.set_method(*method); result != ESP_OK)
         {
@@ -315,100 +777,881 @@ std::expected<void, std::string> AsyncHttpRequest::retry(std::optional<std::stri
             return std::unexpected(std::move(msg));
         }
 
-    if (requestBody)
+    if (requestBodyView)
+    {
+        if (auto result = setRequestBody(std::string_view{(const char *)requestBodyView->data(), requestBodyView->size()}); !result)
+            return std::unexpected(std::move(result).error());
+    }
+    else if (requestBody)
     {
-        m_requestBody = std::move(requestBody).value();
+        storeRequestBody(*requestBody);
         if (!m_requestBody.empty())
-            if (const auto result = m_client.set_post_field(m_requestBody); result != ESP_OK)
-            {
-                auto msg = fmt::format("m_client.set_post_field() failed with {}", esp_err_to_name(result));
-                ESP_LOGE(TAG, "%.*s", msg.size(), msg.data());
-                return std::unexpected(std::move(msg));
-            }
+            if (auto result = setRequestBody(m_requestBody); !result)
+                return std::unexpected(std::move(result).error());
     }
 
-    for (auto iter = std::cbegin(requestHeaders); iter != std::cend(requestHeaders); iter++)
-        if (const auto result = m_client.set_header(iter->first, iter->second); result != ESP_OK)
-        {
-            auto msg = fmt::format("m_client.set_header() failed: {} ({} {})", esp_err_to_name(result), iter->first, iter->second);
-            ESP_LOGW(TAG, "%.*s", msg.size(), msg.data());
-            return std::unexpected(std::move(msg));
-        }
+    if (auto result = setRequestHeaders(requestHeaders); !result)
+        return std::unexpected(std::move(result).error());
 
     m_buf.clear();
+    m_segments.clear();
+    m_responseBuffer = responseBuffer;
+    if (method)
+        m_method = *method;
+    m_responseSize = 0;
 
-    clearFinished();
-    m_eventGroup.setBits(START_REQUEST_BIT);
+    submitRequest();
 
     return {};
 }
 
-std::expected<void, std::string> AsyncHttpRequest::abort()
+std::expected<void, std::string> AsyncHttpRequest::start(const AsyncHttpPreparedRequest &prepared, std::string &&requestBody)
 {
-    if (const auto bits = m_eventGroup.getBits(); !(bits & (START_REQUEST_BIT | REQUEST_RUNNING_BIT)))
-        return std::unexpected("no ota job is running!");
-    else if (bits & ABORT_REQUEST_BIT)
-        return std::unexpected("an abort has already been requested!");
+    auto lock = lockStart();
+    if (!lock)
+        return std::unexpected(std::move(lock).error());
 
-    m_eventGroup.setBits(ABORT_REQUEST_BIT);
-    ESP_LOGI(TAG, "http request abort requested");
+    // queued as a plain request, prepared does not have to outlive it
+    if (auto queued = queueIfBusy({}, prepared.url(), prepared.method(), prepared.headers(), requestBody, {},
+                                  prepared.timeout_ms(), prepared.serverCert(), prepared.clientAuth()))
+        return *std::move(queued);
 
-    return {};
+    return startPrepared({}, prepared, std::move(requestBody), {});
 }
 
-bool AsyncHttpRequest::inProgress() const
+std::expected<void, std::string> AsyncHttpRequest::startView(const AsyncHttpPreparedRequest &prepared,
+                                                             std::span<const std::byte> requestBody,
+                                                             std::span<char> responseBuffer)
 {
-    return m_eventGroup.getBits() & (START_REQUEST_BIT | REQUEST_RUNNING_BIT);
-}
+    auto lock = lockStart();
+    if (!lock)
+        return std::unexpected(std::move(lock).error());
 
-bool AsyncHttpRequest::finished() const
-{
-    return m_eventGroup.getBits() & REQUEST_FINISHED_BIT;
+    std::string noBody;
+    if (auto queued = queueIfBusy(responseBuffer, prepared.url(), prepared.method(), prepared.headers(), noBody, requestBody,
+                                  prepared.timeout_ms(), prepared.serverCert(), prepared.clientAuth()))
+        return *std::move(queued);
+
+    return startPrepared(responseBuffer, prepared, {}, requestBody);
 }
 
-std::expected<void, std::string> AsyncHttpRequest::result() const
+std::expected<void, std::string> AsyncHttpRequest::startPrepared(std::span<char> responseBuffer,
+                                                                 const AsyncHttpPreparedRequest &prepared,
+                                                                 std::string &&requestBody,
+                                                                 std::span<const std::byte> requestBodyView)
 {
-    if (const auto bits = m_eventGroup.getBits();
-        bits & REQUEST_RUNNING_BIT)
+    if (busy())
     {
-        constexpr auto msg = "request still running";
+        constexpr auto msg = "another request still in progress";
         ESP_LOGW(TAG, "%s", msg);
         return std::unexpected(msg);
     }
-    else if (!(bits & REQUEST_FINISHED_BIT))
+
+    if (m_client && m_keepAlive && m_preparedId == prepared.id())
     {
-        constexpr auto msg = "request not finished";
-        ESP_LOGW(TAG, "%s", msg);
-        return std::unexpected(msg);
+        // headers are still in place, the url is set again as a redirect may have changed it
+        if (auto result = configureClient(prepared.url(), prepared.method(), prepared.timeout_ms()); !result)
+            return std::unexpected(std::move(result).error());
+    }
+    else
+    {
+        bool reuse{};
+        if (m_client)
+        {
+            if (m_keepAlive && m_clientOrigin == prepared.origin())
+                reuse = true;
+            else
+            {
+                ESP_LOGD(TAG, "old http client for another origin still constructed, releasing now");
+                releaseClient();
+            }
+        }
+
+        if (reuse)
+        {
+            if (auto result = reuseClient(prepared.url(), prepared.method(), prepared.timeout_ms(), prepared.headers()); !result)
+                return std::unexpected(std::move(result).error());
+        }
+        else if (auto result = createClient(prepared.origin(), prepared.url(), prepared.method(), prepared.timeout_ms(),
+                                            prepared.serverCert(), prepared.clientAuth()); !result)
+            return std::unexpected(std::move(result).error());
+
+        if (auto result = setRequestHeaders(prepared.headers()); !result)
+            return std::unexpected(std::move(result).error());
+
+        m_preparedId = prepared.id();
     }
 
-    if (m_result != ESP_OK)
-        return std::unexpected(fmt::format("http request failed: {}", esp_err_to_name(m_result)));
+    storeRequestBody(requestBody);
+    const auto body = requestBodyView.data() ? std::string_view{(const char *)requestBodyView.data(), requestBodyView.size()} : std::string_view{m_requestBody};
+    if (auto result = setRequestBody(body); !result)
+        return std::unexpected(std::move(result).error());
+
+    m_buf.clear();
+    m_segments.clear();
+    m_responseBuffer = responseBuffer;
+    m_method = prepared.method();
+    m_responseSize = 0;
+
+    submitRequest();
 
     return {};
 }
 
-void AsyncHttpRequest::clearFinished()
+std::expected<void, std::string> AsyncHttpRequest::abort()
+{
+    if (const auto bits = m_eventGroup.getBits(); !(bits & (START_REQUEST_BIT | REQUEST_RUNNING_BIT)))
+        return std::unexpected("no ota job is running!");
+    else if (bits & ABORT_REQUEST_BIT)
+        return std::unexpected("an abort has already been requested!");
+
+    m_eventGroup.setBits(ABORT_REQUEST_BIT);
+    ESP_LOGI(TAG, "http request abort requested");
+
+    if (m_worker)
+        m_worker->notify();
+
+    return {};
+}
+
+std::expected<void, std::string> AsyncHttpRequest::startSchedule(const Schedule &schedule, ScheduleCallback &&callback)
+{
+    if (schedule.interval <= 0ms)
+    {
+        constexpr auto msg = "schedule interval has to be positive";
+        ESP_LOGW(TAG, "%s", msg);
+        return std::unexpected(msg);
+    }
+
+    if (m_releaseAfterRequest)
+    {
+        constexpr auto msg = "schedule not possible with releaseAfterRequest";
+        ESP_LOGW(TAG, "%s", msg);
+        return std::unexpected(msg);
+    }
+
+    if (auto result = ensureTask(); !result)
+        return std::unexpected(std::move(result).error());
+
+    std::lock_guard lock{m_startMutex};
+
+    if (scheduled())
+    {
+        constexpr auto msg = "schedule already running";
+        ESP_LOGW(TAG, "%s", msg);
+        return std::unexpected(msg);
+    }
+
+    if (inProgress())
+    {
+        constexpr auto msg = "another request still in progress";
+        ESP_LOGW(TAG, "%s", msg);
+        return std::unexpected(msg);
+    }
+
+    if (!m_client)
+    {
+        constexpr auto msg = "http client is null";
+        ESP_LOGW(TAG, "%s", msg);
+        return std::unexpected(msg);
+    }
+
+    m_schedule = schedule;
+    m_scheduleCallback = std::move(callback);
+    m_scheduleHasPrevious = false;
+    m_scheduleBase = espchrono::millis_clock::now();
+    m_nextScheduled = m_scheduleBase;
+    m_responseBuffer = {};
+
+    // the first cycle is submitted right away, every later one is claimed by claimScheduledCycle()
+    m_eventGroup.setBits(SCHEDULED_BIT);
+    prepareScheduledRequest();
+    submitRequest();
+
+    return {};
+}
+
+void AsyncHttpRequest::stopSchedule()
+{
+    m_eventGroup.clearBits(SCHEDULED_BIT);
+}
+
+bool AsyncHttpRequest::scheduled() const
+{
+    return m_eventGroup.getBits() & SCHEDULED_BIT;
+}
+
+bool AsyncHttpRequest::inProgress() const
+{
+    return m_eventGroup.getBits() & (START_REQUEST_BIT | REQUEST_RUNNING_BIT);
+}
+
+bool AsyncHttpRequest::busy() const
+{
+    const auto bits = m_eventGroup.getBits();
+    if (bits & START_REQUEST_BIT)
+        return true;
+
+    // the completion handlers of the running request may already start the next one
+    return (bits & REQUEST_RUNNING_BIT) && m_completingTask != xTaskGetCurrentTaskHandle();
+}
+
+bool AsyncHttpRequest::completing(EventBits_t bits) const
+{
+    // unless they already started the next request
+    return (bits & REQUEST_RUNNING_BIT) && !(bits & START_REQUEST_BIT) &&
+           m_completingTask == xTaskGetCurrentTaskHandle();
+}
+
+bool AsyncHttpRequest::finished() const
+{
+    const auto bits = m_eventGroup.getBits();
+    return (bits & REQUEST_FINISHED_BIT) || completing(bits);
+}
+
+std::expected<void, std::string> AsyncHttpRequest::result() const
+{
+    if (const auto bits = m_eventGroup.getBits(); completing(bits))
+        return finishedResult();
+    else if (bits & REQUEST_RUNNING_BIT)
+    {
+        constexpr auto msg = "request still running";
+        ESP_LOGW(TAG, "%s", msg);
+        return std::unexpected(msg);
+    }
+    else if (!(bits & REQUEST_FINISHED_BIT))
+    {
+        constexpr auto msg = "request not finished";
+        ESP_LOGW(TAG, "%s", msg);
+        return std::unexpected(msg);
+    }
+
+    return finishedResult();
+}
+
+std::expected<void, std::string> AsyncHttpRequest::finishedResult() const
+{
+    if (m_result == ESP_ERR_INVALID_SIZE && m_contentLength)
+        return std::unexpected(fmt::format("http request failed: response too large ({} bytes declared, limit {})", *m_contentLength, m_rejectedLimit));
+
+    if (m_result != ESP_OK)
+        return std::unexpected(fmt::format("http request failed: {}", esp_err_to_name(m_result)));
+
+    return {};
+}
+
+bool AsyncHttpRequest::waitFinished(std::optional<std::chrono::milliseconds> timeout)
+{
+    const TickType_t ticks = timeout ? std::chrono::ceil<espcpputils::ticks>(*timeout).count() : portMAX_DELAY;
+    return m_eventGroup.waitBits(REQUEST_FINISHED_BIT, false, false, ticks) & REQUEST_FINISHED_BIT;
+}
+
+void AsyncHttpRequest::setBufferCaps(uint32_t caps)
+{
+    m_segments.setCaps(caps);
+    m_buf = AsyncHttpString{AsyncHttpCapsAllocator<char>{caps}};
+    m_responseHeaders.setCaps(caps);
+    // the post field of the client may still point into m_requestBody, it moves with the next owned body
+}
+
+auto AsyncHttpRequest::memoryUsage() const -> MemoryUsage
+{
+    MemoryUsage usage;
+
+    accountMemory(usage, m_buf);
+    accountMemory(usage, m_requestBody);
+
+    for (const auto segment : m_segments)
+        accountMemory(usage, segment.data(), AsyncHttpSegmentedBuffer::SegmentSize);
+
+    accountMemory(usage, m_responseHeaders.storage(), m_responseHeaders.allocatedBytes());
+
+    for (const auto &key : m_requestHeaderKeys)
+        accountMemory(usage, key);
+
+    return usage;
+}
+
+void AsyncHttpRequest::clearFinished()
 {
     m_eventGroup.clearBits(REQUEST_FINISHED_BIT);
 }
 
+std::expected<void, std::string> AsyncHttpRequest::reuseClient(std::string_view url, esp_http_client_method_t method, int timeout_ms,
+                                                               const RequestHeaders &requestHeaders)
+{
+    m_preparedId = 0;
+
+    if (auto result = configureClient(url, method, timeout_ms); !result)
+        return std::unexpected(std::move(result).error());
+
+    // headers of the previous request would otherwise be sent again
+    deleteRequestHeaders(requestHeaders);
+
+    ESP_LOGD(TAG, "reusing http client %s (connected=%s)", m_taskName, m_connected ? "true" : "false");
+
+    return {};
+}
+
+std::expected<void, std::string> AsyncHttpRequest::configureClient(std::string_view url, esp_http_client_method_t method, int timeout_ms)
+{
+    if (const auto result = m_client.set_url(url); result != ESP_OK)
+    {
+        auto msg = fmt::format("m_client.set_url() failed: {} ({})", esp_err_to_name(result), url);
+        ESP_LOGW(TAG, "%.*s", msg.size(), msg.data());
+        return std::unexpected(std::move(msg));
+    }
+
+    if (const auto result = m_client.set_method(method); result != ESP_OK)
+    {
+        auto msg = fmt::format("m_client.set_method() failed: {}", esp_err_to_name(result));
+        ESP_LOGW(TAG, "%.*s", msg.size(), msg.data());
+        return std::unexpected(std::move(msg));
+    }
+
+    if (const auto result = m_client.set_timeout_ms(timeout_ms > 0 ? timeout_ms : DEFAULT_TIMEOUT_MS); result != ESP_OK)
+    {
+        auto msg = fmt::format("m_client.set_timeout_ms() failed: {}", esp_err_to_name(result));
+        ESP_LOGW(TAG, "%.*s", msg.size(), msg.data());
+        return std::unexpected(std::move(msg));
+    }
+
+    return {};
+}
+
+void AsyncHttpRequest::deleteRequestHeaders(const RequestHeaders &keep)
+{
+    for (auto iter = std::begin(m_requestHeaderKeys); iter != std::end(m_requestHeaderKeys); )
+    {
+        if (keep.contains(*iter))
+        {
+            iter++;
+            continue;
+        }
+
+        if (const auto result = esp_http_client_delete_header(m_client.handle, iter->c_str()); result != ESP_OK)
+            ESP_LOGW(TAG, "esp_http_client_delete_header() failed: %s (%s)", esp_err_to_name(result), iter->c_str());
+        iter = m_requestHeaderKeys.erase(iter);
+    }
+}
+
+void AsyncHttpRequest::releaseClient()
+{
+    if (m_client && m_usePool && m_clientOrigin)
+    {
+        if (m_connected && !m_keepAlive)
+            m_client.close();
+
+        if (m_connected || m_clientHasSession)
+        {
+            // leave nothing behind that refers to this instance
+            deleteRequestHeaders();
+            m_client.set_post_field({});
+
+            ESP_LOGD(TAG, "returning http client %s to the connection pool", m_taskName);
+            AsyncHttpConnectionPool::instance().checkin(*m_clientOrigin, std::move(m_client), m_connected, m_clientHasSession);
+        }
+    }
+
+    m_client = {};
+    m_clientOrigin = std::nullopt;
+    m_connected = false;
+    m_clientHasSession = false;
+    m_requestHeaderKeys.clear();
+    m_preparedId = 0;
+}
+
+std::expected<void, std::string> AsyncHttpRequest::setRequestHeaders(const RequestHeaders &requestHeaders)
+{
+    return requestHeaders.forEach([&](std::string_view key, std::string_view value) -> std::expected<void, std::string> {
+        if (const auto result = m_client.set_header(key, value); result != ESP_OK)
+        {
+            auto msg = fmt::format("m_client.set_header() failed: {} ({} {})", esp_err_to_name(result), key, value);
+            ESP_LOGW(TAG, "%.*s", msg.size(), msg.data());
+            return std::unexpected(std::move(msg));
+        }
+
+        if (std::find(std::cbegin(m_requestHeaderKeys), std::cend(m_requestHeaderKeys), key) == std::cend(m_requestHeaderKeys))
+            m_requestHeaderKeys.emplace_back(key);
+
+        return {};
+    });
+}
+
+void AsyncHttpRequest::storeRequestBody(std::string_view body)
+{
+    if (m_requestBody.get_allocator().caps() != bufferCaps())
+        m_requestBody = AsyncHttpString{body, AsyncHttpCapsAllocator<char>{bufferCaps()}};
+    else
+        m_requestBody.assign(body);
+}
+
+std::expected<void, std::string> AsyncHttpRequest::setRequestBody(std::string_view body)
+{
+    // a null pointer resets the body left over from the previous request of a reused client
+    if (const auto result = m_client.set_post_field(body.empty() ? std::string_view{} : body); result != ESP_OK)
+    {
+        auto msg = fmt::format("m_client.set_post_field() failed with {}", esp_err_to_name(result));
+        ESP_LOGE(TAG, "%.*s", msg.size(), msg.data());
+        return std::unexpected(std::move(msg));
+    }
+
+    m_requestBodySize = body.size();
+
+    return {};
+}
+
+bool AsyncHttpRequest::RequestHeaders::contains(std::string_view key) const
+{
+    if (m_map && std::any_of(std::begin(*m_map), std::end(*m_map), [&](const auto &header){ return header.first == key; }))
+        return true;
+
+    return std::any_of(std::begin(m_views), std::end(m_views), [&](const HeaderView &header){ return header.first == key; });
+}
+
+std::optional<std::size_t> AsyncHttpRequest::bodyLimit() const
+{
+    if (m_responseBuffer.data())
+        return m_responseBuffer.size();
+    if (m_bodySink && m_oversizePolicy != OversizePolicy::SpillToSink)
+        return std::nullopt;
+    return m_sizeLimit;
+}
+
+std::expected<void, std::string> AsyncHttpRequest::ensureTask()
+{
+    if (m_worker)
+        return m_worker->ensureTasks();
+
+    if (m_polled)
+        return {};
+
+    if (!m_taskHandle)
+        return startTask();
+
+    return {};
+}
+
+void AsyncHttpRequest::submitRequest()
+{
+    m_activePriority = m_priority;
+    m_activeDeadline = m_deadline;
+
+    clearFinished();
+    m_eventGroup.setBits(START_REQUEST_BIT);
+
+    if (m_worker)
+        m_worker->notify();
+}
+
+bool AsyncHttpRequest::beginRequest()
+{
+    assert(m_client);
+
+    m_eventGroup.setBits(REQUEST_RUNNING_BIT);
+    m_eventGroup.clearBits(START_REQUEST_BIT);
+
+    {
+        const auto bits = m_eventGroup.getBits();
+        assert(!(bits & REQUEST_FINISHED_BIT));
+    }
+
+    m_timing = RequestTiming{ .started = espchrono::millis_clock::now() };
+
+    // before anything is accounted for or the connection is touched
+    m_dropped = m_activeDeadline && m_timing.started > *m_activeDeadline;
+    if (m_dropped)
+    {
+        ESP_LOGW(TAG, "%s deadline passed before the request started, dropping it", m_taskName);
+        return false;
+    }
+
+    m_pollInterval = POLL_INTERVAL_MIN;
+    m_responseStarted = false;
+    m_bodyError = ESP_OK;
+    m_contentLength = std::nullopt;
+    m_spillToSink = false;
+
+    m_connectionReused = m_connected;
+    if (m_connectionReused)
+    {
+        m_reuseHits++;
+        m_handshake = Handshake::None;
+        m_handshakeDuration = {};
+    }
+    else
+    {
+        m_reuseMisses++;
+        beginConnect();
+    }
+
+    if (m_activePriority == Priority::Interactive)
+    {
+        m_countedInteractive = true;
+        interactiveRequests++;
+    }
+
+    return true;
+}
+
+bool AsyncHttpRequest::pausedForInteractive() const
+{
+    return m_activePriority == Priority::Bulk && m_pauseForInteractive && interactiveRequests > 0;
+}
+
+void AsyncHttpRequest::beginConnect()
+{
+    if (!m_clientOrigin || m_clientOrigin->scheme != "https")
+        m_handshake = Handshake::Plain;
+    else if (m_clientHasSession)
+        m_handshake = Handshake::TlsSessionOffered;
+    else
+        m_handshake = Handshake::TlsFull;
+
+    m_handshakeDuration = {};
+    m_connectStarted = espchrono::millis_clock::now();
+}
+
+std::optional<esp_err_t> AsyncHttpRequest::performStep()
+{
+    if (m_eventGroup.clearBits(ABORT_REQUEST_BIT) & ABORT_REQUEST_BIT)
+    {
+        ESP_LOGW(TAG, "abort request received");
+        return ESP_FAIL;
+    }
+
+    // not reading lets the tcp window fill up, which leaves the bandwidth to the interactive requests
+    if (pausedForInteractive())
+    {
+        m_pollInterval = POLL_INTERVAL_MAX;
+        return std::nullopt;
+    }
+
+    m_progress = false;
+    const auto result = m_client.perform();
+    ESP_LOG_LEVEL_LOCAL((cpputils::is_in(result, ESP_OK, EAGAIN, EINPROGRESS, ESP_ERR_HTTP_EAGAIN) ? ESP_LOG_DEBUG : ESP_LOG_WARN),
+                        TAG, "m_client.perform() returned: %s", result == EAGAIN ? "EAGAIN" : (result == EINPROGRESS ? "EINPROGRESS" : esp_err_to_name(result)));
+
+    // esp_http_client does not stop reading when the event handler fails
+    if (m_bodyError != ESP_OK)
+    {
+        ESP_LOGW(TAG, "%s response body rejected: %s", m_taskName, esp_err_to_name(m_bodyError));
+        return m_bodyError;
+    }
+
+    if (m_connectionReused && !m_responseStarted && connectionLost(result) && idempotent(m_method))
+    {
+        // the server closed the kept-alive connection while it was idle, try once more with a new one
+        ESP_LOGI(TAG, "%s kept-alive connection failed (%s), reconnecting", m_taskName, esp_err_to_name(result));
+        m_connectionReused = false;
+        m_client.close();
+        beginConnect();
+        m_pollInterval = POLL_INTERVAL_MIN;
+        return std::nullopt;
+    }
+
+    if (!cpputils::is_in(result, EAGAIN, EINPROGRESS, ESP_ERR_HTTP_EAGAIN))
+        return result;
+
+    // back off while the connection is idle, come back quickly while data is flowing
+    m_pollInterval = m_progress ? POLL_INTERVAL_MIN : std::min<std::chrono::milliseconds>(m_pollInterval * 2, POLL_INTERVAL_MAX);
+
+    return std::nullopt;
+}
+
+void AsyncHttpRequest::finishRequest(esp_err_t result)
+{
+    m_timing.finished = espchrono::millis_clock::now();
+    m_result = result;
+    m_statusCode = m_dropped ? 0 : m_client.get_status_code();
+
+    if (m_countedInteractive)
+    {
+        m_countedInteractive = false;
+        interactiveRequests--;
+    }
+
+    // on success perform() already closed the connection if the server does not keep it alive,
+    // a dropped request never used it
+    if ((result != ESP_OK || !m_keepAlive) && !m_dropped)
+    {
+        const auto result = m_client.close();
+        ESP_LOGD(TAG, "m_client.close() returned: %s", esp_err_to_name(result));
+    }
+
+    if (m_releaseAfterRequest)
+        releaseClient();
+
+#ifdef CONFIG_ASYNC_HTTP_METRICS
+    if (!m_dropped)
+        AsyncHttpMetrics::instance().record(AsyncHttpMetrics::Sample {
+            .result = result,
+            .statusCode = m_statusCode,
+            .bytesIn = m_responseSize,
+            .bytesOut = m_requestBodySize,
+            .total = m_timing.total(),
+            .timeToFirstByte = m_timing.timeToFirstByte(),
+            .connectionReused = m_connectionReused,
+        });
+#endif
+
+    // before REQUEST_RUNNING_BIT is cleared, so the callback cannot race with a new start()
+    if (m_eventGroup.getBits() & SCHEDULED_BIT)
+        finishScheduledRequest(result);
+
+    ESP_LOGI(TAG, "%s request finished", m_taskName);
+    m_eventGroup.clearBits(ABORT_REQUEST_BIT);
+
+    // REQUEST_RUNNING_BIT stays set while the completion handlers read the response, only they
+    // (running in this task) may start the next request meanwhile, see busy()
+    m_completingTask = xTaskGetCurrentTaskHandle();
+    notifyCompletion(result);
+    m_completingTask = nullptr;
+
+    m_eventGroup.clearBits(REQUEST_RUNNING_BIT);
+
+    // a request started by the completion handlers keeps the instance busy
+    if (!(m_eventGroup.getBits() & START_REQUEST_BIT))
+    {
+        m_eventGroup.setBits(REQUEST_FINISHED_BIT);
+
+        // an awaitable suspending meanwhile saw neither the handle exchange nor the finished bit
+        if (const auto coroutine = m_awaitingCoroutine.exchange(nullptr))
+            std::coroutine_handle<>::from_address(coroutine).resume();
+    }
+
+    // back-to-back on the same client, unless the completion handlers already started the next request
+    startQueuedRequest();
+}
+
+void AsyncHttpRequest::notifyCompletion(esp_err_t result)
+{
+    if (m_postCompletionEvent)
+    {
+        const AsyncHttpFinishedEvent event {
+            .request = this,
+            .result = result,
+            .statusCode = m_statusCode,
+        };
+
+        // never block the request task on a full event queue
+        const auto postResult = m_completionEventLoop ?
+            esp_event_post_to(m_completionEventLoop, ASYNC_HTTP_EVENT, ASYNC_HTTP_EVENT_FINISHED, &event, sizeof(event), 0) :
+            esp_event_post(ASYNC_HTTP_EVENT, ASYNC_HTTP_EVENT_FINISHED, &event, sizeof(event), 0);
+        if (postResult != ESP_OK)
+            ESP_LOGW(TAG, "%s posting finished event failed: %s", m_taskName, esp_err_to_name(postResult));
+    }
+
+    if (m_completionCallback)
+        m_completionCallback(*this, result);
+
+    if (const auto coroutine = m_awaitingCoroutine.exchange(nullptr))
+        std::coroutine_handle<>::from_address(coroutine).resume();
+}
+
+bool AsyncHttpRequest::claimScheduledCycle()
+{
+    std::lock_guard lock{m_startMutex};
+
+    // a start() or stopSchedule() may have won the race, the cycle is skipped then
+    if (!(m_eventGroup.getBits() & SCHEDULED_BIT) || inProgress())
+        return false;
+
+    prepareScheduledRequest();
+    submitRequest();
+
+    return true;
+}
+
+void AsyncHttpRequest::prepareScheduledRequest()
+{
+    ESP_LOGD(TAG, "%s starting scheduled request", m_taskName);
+
+    m_buf.clear();
+    m_segments.clear();
+    m_responseSize = 0;
+    clearFinished();
+}
+
+void AsyncHttpRequest::finishScheduledRequest(esp_err_t result)
+{
+    const bool changed = !m_scheduleHasPrevious ||
+                         result != m_schedulePreviousResult ||
+                         m_statusCode != m_schedulePreviousStatusCode ||
+                         m_bodyHash != m_schedulePreviousBodyHash;
+
+    m_scheduleHasPrevious = true;
+    m_schedulePreviousResult = result;
+    m_schedulePreviousStatusCode = m_statusCode;
+    m_schedulePreviousBodyHash = m_bodyHash;
+
+    if (m_scheduleCallback && (changed || result != ESP_OK || m_schedule.notifyUnchanged))
+        m_scheduleCallback(*this, result);
+
+    if (!m_client)
+    {
+        ESP_LOGW(TAG, "%s client gone, stopping schedule", m_taskName);
+        m_eventGroup.clearBits(SCHEDULED_BIT);
+        return;
+    }
+
+    // fixed rate, cycles that are already over are skipped
+    const auto now = espchrono::millis_clock::now();
+    m_scheduleBase += m_schedule.interval;
+    if (m_scheduleBase < now)
+        m_scheduleBase = now;
+
+    std::chrono::milliseconds jitter{};
+    if (m_schedule.jitter > 0ms)
+        jitter = std::chrono::milliseconds{esp_random() % (m_schedule.jitter.count() + 1)};
+
+    m_nextScheduled = m_scheduleBase + jitter;
+}
+
+std::optional<std::chrono::milliseconds> AsyncHttpRequest::RequestTiming::connect() const
+{
+    if (!connected)
+        return std::nullopt;
+    return *connected - started;
+}
+
+std::optional<std::chrono::milliseconds> AsyncHttpRequest::RequestTiming::timeToFirstByte() const
+{
+    if (!headersReceived)
+        return std::nullopt;
+    return *headersReceived - connected.value_or(started);
+}
+
+std::optional<std::chrono::milliseconds> AsyncHttpRequest::RequestTiming::transfer() const
+{
+    if (!firstBodyByte)
+        return std::nullopt;
+    return finished - *firstBodyByte;
+}
+
+bool AsyncHttpRequest::poll(std::chrono::milliseconds budget)
+{
+    if (!m_polled)
+    {
+        ESP_LOGW(TAG, "%s poll() is only for polled requests", m_taskName);
+        return inProgress();
+    }
+
+    const auto end = espchrono::millis_clock::now() + budget;
+    do
+    {
+        // the adaptive poll interval keeps an idle connection from burning the callers loop
+        if (const auto due = nextStepDue(); !due || *due > espchrono::millis_clock::now())
+            break;
+
+        step();
+    } while (espchrono::millis_clock::now() < end);
+
+    return inProgress();
+}
+
+std::optional<espchrono::millis_clock::time_point> AsyncHttpRequest::nextStepDue() const
+{
+    const auto bits = m_eventGroup.getBits();
+    if (bits & REQUEST_RUNNING_BIT)
+        return (bits & ABORT_REQUEST_BIT) ? espchrono::millis_clock::time_point{} : m_nextPoll;
+    else if (bits & START_REQUEST_BIT)
+        return espchrono::millis_clock::time_point{};
+    else if (bits & SCHEDULED_BIT)
+        return m_nextScheduled;
+
+    return std::nullopt;
+}
+
+void AsyncHttpRequest::step()
+{
+    if (const auto bits = m_eventGroup.getBits(); !(bits & REQUEST_RUNNING_BIT))
+    {
+        if (!(bits & START_REQUEST_BIT) && !claimScheduledCycle())
+            return;
+        if (!beginRequest())
+        {
+            finishRequest(ESP_ERR_TIMEOUT);
+            return;
+        }
+    }
+
+    if (const auto result = performStep())
+        finishRequest(*result);
+    else
+        m_nextPoll = espchrono::millis_clock::now() + m_pollInterval;
+}
+
 esp_err_t AsyncHttpRequest::httpEventHandler(esp_http_client_event_t *evt)
 {
+    m_progress = true;
+
     switch(evt->event_id)
     {
+    case HTTP_EVENT_ON_CONNECTED:
+        m_connected = true;
+        m_timing.connected = espchrono::millis_clock::now();
+        m_handshakeDuration = *m_timing.connected - m_connectStarted;
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        if (m_clientOrigin && m_clientOrigin->scheme == "https")
+            m_clientHasSession = true;
+#endif
+        break;
+    case HTTP_EVENT_DISCONNECTED:
+        m_connected = false;
+        break;
+    case HTTP_EVENT_HEADERS_SENT:
+        // a new response follows (also after redirects and auth retries)
+        m_buf.clear();
+        m_segments.clear();
+        m_responseSize = 0;
+        m_bodyError = ESP_OK;
+        m_contentLength = std::nullopt;
+        m_spillToSink = false;
+        m_responseHeaders.clear();
+        m_bodyHash = FNV_OFFSET_BASIS;
+        m_timing.headersReceived = std::nullopt;
+        m_timing.firstBodyByte = std::nullopt;
+        m_bodyStats = {};
+        break;
     case HTTP_EVENT_ON_HEADER:
+        m_responseStarted = true;
+        if (!m_timing.headersReceived)
+            m_timing.headersReceived = espchrono::millis_clock::now();
         if (evt->header_key && evt->header_value)
         {
-            if (m_collectResponseHeaders)
-                m_responseHeaders.emplace(std::make_pair(evt->header_key, evt->header_value));
+            if (m_collectResponseHeaders && m_responseHeaderFilter.matches(evt->header_key))
+                m_responseHeaders.append(evt->header_key, evt->header_value);
             if (strcasecmp(evt->header_key, "Content-Length") == 0)
             {
                 unsigned int size;
                 if (std::sscanf(evt->header_value, "%u", &size) == 1)
                 {
-                    //ESP_LOGD(TAG, "reserving %u bytes for http buffer", size);
-                    m_buf.reserve(std::min(size, m_sizeLimit));
+                    m_contentLength = size;
+
+                    const auto statusCode = esp_http_client_get_status_code(evt->client);
+                    const bool hasBody = m_method != HTTP_METHOD_HEAD && statusCode != 204 && statusCode != 304 && !(statusCode >= 300 && statusCode < 400);
+
+                    if (const auto limit = bodyLimit(); hasBody && limit && size > *limit)
+                    {
+                        if (m_oversizePolicy == OversizePolicy::SpillToSink && m_bodySink)
+                        {
+                            ESP_LOGI(TAG, "%s response of %u bytes exceeds limit %zu, spilling to body sink", m_taskName, size, *limit);
+                            m_spillToSink = true;
+                        }
+                        else
+                        {
+                            // rejected before the body is read, performStep() ends the request
+                            ESP_LOGW(TAG, "%s response of %u bytes exceeds limit %zu", m_taskName, size, *limit);
+                            m_rejectedLimit = *limit;
+                            m_bodyError = ESP_ERR_INVALID_SIZE;
+                        }
+                    }
+                    else if (!m_responseBuffer.data() && !m_segmented && (!m_bodySink || m_oversizePolicy == OversizePolicy::SpillToSink))
+                    {
+                        //ESP_LOGD(TAG, "reserving %u bytes for http buffer", size);
+                        m_buf.reserve(std::min<std::size_t>(size, m_sizeLimit));
+                    }
                 }
                 else
                 {
@@ -418,18 +1661,74 @@ esp_err_t AsyncHttpRequest::httpEventHandler(esp_http_client_event_t *evt)
         }
         break;
     case HTTP_EVENT_ON_DATA:
+        if (!m_timing.firstBodyByte)
+            m_timing.firstBodyByte = espchrono::millis_clock::now();
+
+        if (evt->data_len > 0)
+        {
+            const auto size = std::size_t(evt->data_len);
+            m_bodyStats.smallestChunk = m_bodyStats.dataEvents ? std::min(m_bodyStats.smallestChunk, size) : size;
+            m_bodyStats.largestChunk = std::max(m_bodyStats.largestChunk, size);
+            m_bodyStats.dataEvents++;
+        }
+        if (evt->data && evt->data_len > 0 && (m_eventGroup.getBits() & SCHEDULED_BIT))
+            for (const auto c : std::string_view{(const char *)evt->data, size_t(evt->data_len)})
+                m_bodyHash = (m_bodyHash ^ uint8_t(c)) * FNV_PRIME;
+
         if (!evt->data)
             ESP_LOGW(TAG, "handler with invalid data ptr");
         else if (evt->data_len <= 0)
             ESP_LOGW(TAG, "handler with invalid data_len %i", evt->data_len);
+        else if (m_bodyError != ESP_OK)
+            return m_bodyError; // performStep() ends the request
+        else if (m_responseBuffer.data() && !m_spillToSink)
+        {
+            const auto remainingSize = m_responseBuffer.size() - m_responseSize;
+            const auto size = std::min<size_t>(evt->data_len, remainingSize);
+            std::copy_n((const char *)evt->data, size, std::begin(m_responseBuffer) + m_responseSize);
+            m_responseSize += size;
+            if (remainingSize < size_t(evt->data_len))
+                return m_bodyError = ESP_ERR_NO_MEM;
+        }
+        else if (m_bodySink && (m_oversizePolicy != OversizePolicy::SpillToSink || m_spillToSink))
+        {
+            // the body of a redirect that gets followed is of no interest
+            if (const auto statusCode = esp_http_client_get_status_code(evt->client); statusCode >= 300 && statusCode < 400)
+                break;
+
+            if (const auto result = m_bodySink(std::span<const std::byte>{(const std::byte *)evt->data, size_t(evt->data_len)}); result != ESP_OK)
+            {
+                ESP_LOGW(TAG, "body sink failed with %s", esp_err_to_name(result));
+                m_bodyError = result;
+                return result;
+            }
+
+            m_responseSize += evt->data_len;
+        }
+        else if (m_segmented)
+        {
+            const auto size = std::min<size_t>(evt->data_len, m_sizeLimit - std::min(m_segments.size(), m_sizeLimit));
+            if (!m_segments.append(std::string_view((const char *)evt->data, size)))
+            {
+                ESP_LOGW(TAG, "could not allocate response segment");
+                return m_bodyError = ESP_ERR_NO_MEM;
+            }
+            m_responseSize = m_segments.size();
+            if (size < size_t(evt->data_len))
+                return m_bodyError = ESP_ERR_NO_MEM;
+        }
         else if (m_buf.size() >= m_sizeLimit)
-            return ESP_ERR_NO_MEM;
+            return m_bodyError = ESP_ERR_NO_MEM;
         else
         {
             const auto remainingSize = m_sizeLimit - m_buf.size();
+            const auto capacity = m_buf.capacity();
             m_buf += std::string_view((const char *)evt->data, std::min<size_t>(evt->data_len, remainingSize));
+            if (m_buf.capacity() != capacity)
+                m_bodyStats.bufferGrowths++;
+            m_responseSize = m_buf.size();
             if (remainingSize < evt->data_len)
-                return ESP_ERR_NO_MEM;
+                return m_bodyError = ESP_ERR_NO_MEM;
         }
 
         break;
@@ -444,7 +1743,9 @@ esp_err_t AsyncHttpRequest::staticHttpEventHandler(esp_http_client_event_t *evt)
 {
     auto _this = reinterpret_cast<AsyncHttpRequest*>(evt->user_data);
 
-    assert(_this);
+    // idle clients in the connection pool have no owner
+    if (!_this)
+        return ESP_OK;
 
     return _this->httpEventHandler(evt);
 }
@@ -466,16 +1767,35 @@ void AsyncHttpRequest::requestTask()
     // cleanup on task exit
     auto helper = cpputils::makeCleanupHelper([&](){
         ESP_LOGI(TAG, "%s task ended", m_taskName);
+
+        // endTask() may destroy this instance as soon as TASK_ENDED_BIT is set, nothing touches it afterwards
+        const bool staticTask = m_taskStack.data();
+        if (!staticTask)
+            m_taskHandle = NULL;
+
         m_eventGroup.clearBits(TASK_RUNNING_BIT);
         m_eventGroup.setBits(TASK_ENDED_BIT);
-        m_taskHandle = NULL;
-        vTaskDelete(NULL);
+
+        // a static stack is still in use until endTask() deleted the task
+        if (staticTask)
+            vTaskSuspend(NULL);
+        else
+            vTaskDelete(NULL);
     });
 
     while (true)
     {
+        TickType_t timeout = persistentTask() ? portMAX_DELAY : std::chrono::ceil<espcpputils::ticks>(15s).count();
+        if (m_eventGroup.getBits() & SCHEDULED_BIT)
+        {
+            const std::chrono::milliseconds remaining = m_nextScheduled - espchrono::millis_clock::now();
+            timeout = remaining > 0ms ? std::chrono::ceil<espcpputils::ticks>(remaining).count() : 0;
+        }
+
         ESP_LOGI(TAG, "%s waiting for instructions...", m_taskName);
-        if (const auto bits = m_eventGroup.waitBits(START_REQUEST_BIT|END_TASK_BIT, true, false, std::chrono::ceil<espcpputils::ticks>(15s).count());
+        // START_REQUEST_BIT stays set until beginRequest() replaced it with REQUEST_RUNNING_BIT,
+        // so inProgress() does not report an idle instance in between
+        if (const auto bits = m_eventGroup.waitBits(START_REQUEST_BIT|END_TASK_BIT, false, false, timeout);
             bits & END_TASK_BIT)
         {
             ESP_LOGI(TAG, "%s task end requested", m_taskName);
@@ -486,56 +1806,36 @@ void AsyncHttpRequest::requestTask()
             ESP_LOGI(TAG, "%s start request requested", m_taskName);
             //break;
         }
+        else if (bits & SCHEDULED_BIT)
+        {
+            if (!claimScheduledCycle())
+                continue;
+        }
+        else if (persistentTask())
+            // the wait timed out for a schedule stopped meanwhile
+            continue;
         else
         {
             ESP_LOGI(TAG, "%s timeout ends task", m_taskName);
             break;
         }
 
-        assert(m_client);
-
+        if (!beginRequest())
         {
-            const auto bits = m_eventGroup.getBits();
-            // assert(!(bits & START_REQUEST_BIT));
-            assert(!(bits & REQUEST_RUNNING_BIT));
-            assert(!(bits & REQUEST_FINISHED_BIT));
+            finishRequest(ESP_ERR_TIMEOUT);
+            continue;
         }
 
-        m_eventGroup.setBits(REQUEST_RUNNING_BIT);
-
-        auto helper2 = cpputils::makeCleanupHelper([&](){
-            ESP_LOGI(TAG, "%s request finished", m_taskName);
-            m_eventGroup.clearBits(REQUEST_RUNNING_BIT | ABORT_REQUEST_BIT);
-            m_eventGroup.setBits(REQUEST_FINISHED_BIT);
-        });
-
+        while (true)
         {
-            esp_err_t result;
-            do
+            if (const auto result = performStep())
             {
-                m_buf.clear();
-                result = m_client.perform();
-                ESP_LOG_LEVEL_LOCAL((cpputils::is_in(result, ESP_OK, EAGAIN, EINPROGRESS, ESP_ERR_HTTP_EAGAIN) ? ESP_LOG_DEBUG : ESP_LOG_WARN),
-                                    TAG, "m_client.perform() returned: %s", result == EAGAIN ? "EAGAIN" : (result == EINPROGRESS ? "EINPROGRESS" : esp_err_to_name(result)));
-
-                if (m_eventGroup.clearBits(ABORT_REQUEST_BIT) & ABORT_REQUEST_BIT)
-                {
-                    ESP_LOGW(TAG, "abort request received");
-                    result = ESP_FAIL;
-                    break;
-                }
-
-                espcpputils::delay(500ms);
+                finishRequest(*result);
+                break;
             }
-            while (cpputils::is_in(result, EAGAIN, EINPROGRESS, ESP_ERR_HTTP_EAGAIN));
 
-            m_result = result;
-            m_statusCode = m_client.get_status_code();
-        }
-
-        {
-            const auto result = m_client.close();
-            ESP_LOGD(TAG, "m_client.close() returned: %s", esp_err_to_name(result));
+            // an abort request wakes us up early, performStep() picks it up
+            m_eventGroup.waitBits(ABORT_REQUEST_BIT, false, false, std::chrono::ceil<espcpputils::ticks>(m_pollInterval).count());
         }
     }
 }
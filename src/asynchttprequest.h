@@ -1,33 +1,195 @@
 #pragma once
 
+#include "sdkconfig.h"
+
 // system includes
 #include <string>
 #include <string_view>
+#include <span>
+#include <cstddef>
+#include <functional>
 #include <map>
+#include <vector>
 #include <optional>
 #include <expected>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <algorithm>
+#include <iterator>
+#include <utility>
 
 // esp-idf includes
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <esp_err.h>
+#include <esp_event.h>
 
 // 3rdparty lib includes
 #include <wrappers/http_client.h>
 #include <wrappers/event_group.h>
 #include <taskutils.h>
 #include <clientauth.h>
+#include <espchrono.h>
+
+// local includes
+#include "asynchttporigin.h"
+#include "asynchttpcapsallocator.h"
+#include "asynchttpheaders.h"
+#include "asynchttppreparedrequest.h"
+#include "asynchttpsegmentedbuffer.h"
+
+class AsyncHttpWorker;
+class AsyncHttpRequest;
+class AsyncHttpAwaitable;
+
+ESP_EVENT_DECLARE_BASE(ASYNC_HTTP_EVENT);
+
+enum AsyncHttpEventId : int32_t
+{
+    ASYNC_HTTP_EVENT_FINISHED, // event data is AsyncHttpFinishedEvent
+};
+
+struct AsyncHttpFinishedEvent
+{
+    AsyncHttpRequest *request;
+    esp_err_t result;
+    int statusCode;
+};
 
 class AsyncHttpRequest
 {
+    friend class AsyncHttpWorker;
+    friend class AsyncHttpAwaitable;
+
 public:
+    //! Receives the response body chunk by chunk inside the request task,
+    //! returning anything but ESP_OK aborts the request with that error
+    using BodySink = std::function<esp_err_t(std::span<const std::byte> chunk)>;
+
+    using HeaderView = AsyncHttpHeaderView;
+
+    //! What happens when the declared Content-Length exceeds the size limit
+    enum class OversizePolicy
+    {
+        Abort,       // fail with ESP_ERR_INVALID_SIZE before the body is read
+        SpillToSink, // stream that response into bodySink(), smaller ones are buffered as usual
+    };
+
+    struct MemoryUsage
+    {
+        std::size_t internal{};
+        std::size_t external{};
+    };
+
+    //! Repeats the last request from the request task, the next one starts interval after the
+    //! previous one started, delayed by a random amount of up to jitter
+    struct Schedule
+    {
+        std::chrono::milliseconds interval{};
+        std::chrono::milliseconds jitter{};
+        bool notifyUnchanged{}; // also call the callback when status and body equal the previous response
+    };
+
+    //! Called inside the request task when a scheduled request failed or its response changed,
+    //! buffer(), statusCode() and the other getters already describe the new response
+    using ScheduleCallback = std::function<void(const AsyncHttpRequest &request, esp_err_t result)>;
+
+    //! Called inside the request task right after a request finished, successful or not.
+    //! finished() and result() are already valid inside the callback (other tasks see finished()
+    //! only once it returned), starting the next request from here is fine.
+    using CompletionCallback = std::function<void(AsyncHttpRequest &request, esp_err_t result)>;
+
+    //! Workers step ready requests of a higher priority first, earliest deadline first within a priority
+    enum class Priority : uint8_t
+    {
+        Bulk,        // large background transfers, can be paused while interactive requests run
+        Normal,
+        Interactive, // user initiated, latency matters
+    };
+
+    struct QueueStats
+    {
+        std::size_t depth{};
+        std::size_t maxDepth{};
+        std::size_t enqueued{};
+        std::size_t dequeued{};
+        std::size_t rejected{}; // queue full (or no queue) while busy
+        std::size_t expired{}; // dropped because their deadline passed while queued
+        std::chrono::milliseconds totalWait{};
+        std::chrono::milliseconds maxWait{};
+    };
+
+    //! Monotonic timestamps of the phases of the last request, phases that did not happen are nullopt.
+    //! After a redirect headersReceived and firstBodyByte belong to the final response
+    struct RequestTiming
+    {
+        espchrono::millis_clock::time_point started{};
+        std::optional<espchrono::millis_clock::time_point> connected; // nullopt when a kept-alive connection was used
+        std::optional<espchrono::millis_clock::time_point> headersReceived; // first response header
+        std::optional<espchrono::millis_clock::time_point> firstBodyByte;
+        espchrono::millis_clock::time_point finished{};
+
+        std::chrono::milliseconds total() const { return finished - started; }
+        //! dns, tcp connect and tls handshake
+        std::optional<std::chrono::milliseconds> connect() const;
+        //! From start (or connected) to the first response header
+        std::optional<std::chrono::milliseconds> timeToFirstByte() const;
+        //! From the first body byte until finished
+        std::optional<std::chrono::milliseconds> transfer() const;
+    };
+
+    //! How the body of the last response arrived, shows the cost of fragmented, chunked or dripping responses
+    struct BodyStats
+    {
+        std::size_t dataEvents{}; // HTTP_EVENT_ON_DATA calls, one per chunk or received segment
+        std::size_t smallestChunk{};
+        std::size_t largestChunk{};
+        std::size_t bufferGrowths{}; // reallocations of buffer() while appending
+    };
+
+    enum class Handshake
+    {
+        None,          // an already open connection was used
+        Plain,         // new connection without tls
+        TlsFull,           // new tls connection, no session to offer
+        TlsSessionOffered, // new tls connection offering a cached session, whether the server resumed it is not known here
+    };
+
     AsyncHttpRequest(const char *taskName="httpRequestTask", espcpputils::CoreAffinity coreAffinity=espcpputils::CoreAffinity::Core1, uint32_t taskSize = 3096);
+    //! The task is created with xTaskCreateStatic() on taskStack and taskBuffer, which have to outlive the
+    //! instance. Such a task never ends because of idling, see persistentTask()
+    AsyncHttpRequest(std::span<StackType_t> taskStack, StaticTask_t &taskBuffer,
+                     const char *taskName="httpRequestTask", espcpputils::CoreAffinity coreAffinity=espcpputils::CoreAffinity::Core1);
+    //! Does not create its own task, requests are performed by the task(s) of the worker instead
+    explicit AsyncHttpRequest(AsyncHttpWorker &worker, const char *name="httpRequest");
+
+    struct Polled {};
+    //! Does not use any task, the owner drives requests by calling poll() from its own loop
+    explicit AsyncHttpRequest(Polled, const char *name="httpRequest");
     ~AsyncHttpRequest();
 
     std::expected<void, std::string> startTask();
     std::expected<void, std::string> endTask();
     bool taskRunning() const;
 
+    //! Polled mode only: steps the current request on the stack of the caller until perform() would
+    //! block or budget is used up, without blocking itself (except for dns lookups done by esp_http_client).
+    //! Also finishes requests, runs callbacks and starts scheduled and queued requests.
+    //! Returns true while a request is in progress
+    bool poll(std::chrono::milliseconds budget = {});
+    //! When poll() has work to do next, nullopt if it has none, lets the loop sleep in between
+    std::optional<espchrono::millis_clock::time_point> nextPollDue() const { return nextStepDue(); }
+
+    //! Used by the next startTask()
+    UBaseType_t taskPriority() const { return m_taskPriority; }
+    void setTaskPriority(UBaseType_t taskPriority) { m_taskPriority = taskPriority; }
+
+    //! The task keeps waiting for requests instead of ending after 15s without one,
+    //! so no request pays for creating it again
+    bool persistentTask() const { return m_persistentTask || m_taskStack.data(); }
+    void setPersistentTask(bool persistentTask) { m_persistentTask = persistentTask; }
+
     std::expected<void, std::string> createClient(std::string_view url,
                                                   esp_http_client_method_t method = HTTP_METHOD_GET,
                                                   int timeout_ms = 0,
@@ -46,45 +208,424 @@ public:
                                            std::optional<esp_http_client_method_t> method = std::nullopt,
                                            const std::map<std::string, std::string> &requestHeaders = {},
                                            std::optional<std::string> &&requestBody = {}, std::optional<int> timeout_ms = {});
+
+    //! Same as above, but the response body is written into responseBuffer (which has to stay valid until
+    //! the request finished) instead of buffer(), a body larger than responseBuffer fails with ESP_ERR_NO_MEM.
+    //! A retryInto() on a kept-alive connection does not allocate once the first requests sized the
+    //! buffers, startInto() still allocates while setting up the request (bench/, "allocations")
+    std::expected<void, std::string> startInto(std::span<char> responseBuffer,
+                                               std::string_view url,
+                                               esp_http_client_method_t method = HTTP_METHOD_GET,
+                                               const std::map<std::string, std::string> &requestHeaders = {},
+                                               std::string &&requestBody = {}, int timeout_ms = 0,
+                                               std::string_view serverCert = {},
+                                               const std::optional<cpputils::ClientAuth> &clientAuth = {});
+    std::expected<void, std::string> retryInto(std::span<char> responseBuffer,
+                                               std::optional<std::string_view> url = std::nullopt,
+                                               std::optional<esp_http_client_method_t> method = std::nullopt,
+                                               const std::map<std::string, std::string> &requestHeaders = {},
+                                               std::optional<std::string> &&requestBody = {}, std::optional<int> timeout_ms = {});
+
+    //! Zero-copy variants: neither headers nor body are copied, requestHeaders, requestBody and
+    //! responseBuffer (if not empty) have to stay valid until the request finished
+    std::expected<void, std::string> startView(std::string_view url,
+                                               esp_http_client_method_t method,
+                                               std::span<const HeaderView> requestHeaders,
+                                               std::span<const std::byte> requestBody = {}, int timeout_ms = 0,
+                                               std::string_view serverCert = {},
+                                               const std::optional<cpputils::ClientAuth> &clientAuth = {},
+                                               std::span<char> responseBuffer = {});
+    std::expected<void, std::string> retryView(std::optional<std::string_view> url,
+                                               std::optional<esp_http_client_method_t> method,
+                                               std::span<const HeaderView> requestHeaders,
+                                               std::optional<std::span<const std::byte>> requestBody = {},
+                                               std::optional<int> timeout_ms = {},
+                                               std::span<char> responseBuffer = {});
+
+    //! Starts a request from a template, when the client was set up from the same template
+    //! before only the body is replaced. prepared does not have to outlive the request.
+    std::expected<void, std::string> start(const AsyncHttpPreparedRequest &prepared, std::string &&requestBody = {});
+    std::expected<void, std::string> startView(const AsyncHttpPreparedRequest &prepared,
+                                               std::span<const std::byte> requestBody,
+                                               std::span<char> responseBuffer = {});
+
+    //! Priority and deadline are taken when a request is started or queued
+    Priority priority() const { return m_priority; }
+    void setPriority(Priority priority) { m_priority = priority; }
+
+    //! Requests not begun before the deadline are dropped and finish with ESP_ERR_TIMEOUT
+    std::optional<espchrono::millis_clock::time_point> deadline() const { return m_deadline; }
+    void setDeadline(std::optional<espchrono::millis_clock::time_point> deadline) { m_deadline = deadline; }
+
+    //! Bulk requests stop reading while any interactive request (of any instance) is running,
+    //! the server may close the connection when this takes longer than its timeouts. Paused requests
+    //! poll at the longest interval and work off their backlog at once, on a shared worker that delays
+    //! the next interactive request (bench/, "priority")
+    bool pauseForInteractive() const { return m_pauseForInteractive; }
+    void setPauseForInteractive(bool pauseForInteractive) { m_pauseForInteractive = pauseForInteractive; }
+
+    //! start(), startInto() and startView() (also the prepared overloads) queue the request while another
+    //! one is in progress (up to queueCapacity(), 0 keeps the old behaviour of failing). Queued requests are
+    //! started in order right after the previous one finished, errors while starting them are only logged.
+    //! Url, headers and an owned body are copied into the queue, serverCert, clientAuth and the buffers of
+    //! the zero-copy variants have to stay valid until the queued request finished.
+    std::size_t queueCapacity() const;
+    void setQueueCapacity(std::size_t queueCapacity);
+    std::size_t queueDepth() const;
+    void clearQueue();
+    QueueStats queueStats() const;
+
+    //! Takes the same arguments as start(), co_await on the result resumes the coroutine inside
+    //! the request task once the request finished. Never queued, fails while another request is
+    //! in progress (except from the completion handlers). Defined in asynchttpawaitable.h
+    template<typename ...Args>
+    AsyncHttpAwaitable startAsync(Args &&...args);
+
     std::expected<void, std::string> abort();
 
+    //! Issues the request configured by the last start() (or createClient() and retry()) now and then
+    //! again and again according to schedule until stopSchedule(). Not possible with releaseAfterRequest()
+    std::expected<void, std::string> startSchedule(const Schedule &schedule, ScheduleCallback &&callback);
+    //! A scheduled request already running still finishes
+    void stopSchedule();
+    bool scheduled() const;
+
     bool inProgress() const;
 
     bool finished() const;
     std::expected<void, std::string> result() const;
 
+    //! Blocks until the current request finished, without timeout it waits forever. Returns only after
+    //! the completion callback and an awaiting coroutine are done with the response.
+    //! Returns false on timeout, also when no request was started since clearFinished()
+    bool waitFinished(std::optional<std::chrono::milliseconds> timeout = std::nullopt);
+
+    //! Called from the task driving the request once it finished, before finished() turns true for
+    //! other tasks, see CompletionCallback. It may start the next request, no other task can do so until it returned.
+    const CompletionCallback &completionCallback() const { return m_completionCallback; }
+    void setCompletionCallback(CompletionCallback &&completionCallback) { m_completionCallback = std::move(completionCallback); }
+
+    //! Posts ASYNC_HTTP_EVENT_FINISHED to loop (nullptr for the default event loop) when a request finished
+    void setPostCompletionEvent(bool post, esp_event_loop_handle_t loop = nullptr) { m_postCompletionEvent = post; m_completionEventLoop = loop; }
+    bool postCompletionEvent() const { return m_postCompletionEvent; }
+
     int statusCode() const { return m_statusCode; }
+    const RequestTiming &timing() const { return m_timing; }
+    const BodyStats &bodyStats() const { return m_bodyStats; }
 
     void clearFinished();
 
-    const std::string &buffer() const { return m_buf; }
-    std::string &&takeBuffer() { return std::move(m_buf); }
+    //! Allocated with bufferCaps(), converts to std::string_view
+    const AsyncHttpString &buffer() const { return m_buf; }
+    //! Body bytes received by the last request, regardless of where they were stored
+    std::size_t responseSize() const { return m_responseSize; }
+    AsyncHttpString &&takeBuffer() { return std::move(m_buf); }
 
     std::size_t sizeLimit() const { return m_sizeLimit; }
     void setSizeLimit(std::size_t sizeLimit) { m_sizeLimit = sizeLimit; }
 
+    //! When set the body is streamed into the sink instead of being collected in buffer(), sizeLimit() does not apply
+    const BodySink &bodySink() const { return m_bodySink; }
+    void setBodySink(BodySink &&bodySink) { m_bodySink = std::move(bodySink); }
+
+    OversizePolicy oversizePolicy() const { return m_oversizePolicy; }
+    void setOversizePolicy(OversizePolicy oversizePolicy) { m_oversizePolicy = oversizePolicy; }
+
+    //! Content-Length announced by the last response, if any
+    std::optional<std::size_t> contentLength() const { return m_contentLength; }
+
+    //! Collects the body in fixed size segments instead of one growing string, sizeLimit() still applies
+    bool segmented() const { return m_segmented; }
+    void setSegmented(bool segmented) { m_segmented = segmented; }
+
+    //! Heap buffer(), the segments, the response headers and the copy of an owned request body are allocated
+    //! from, MALLOC_CAP_SPIRAM moves them out of internal ram. Releases the response, not while a request is in progress
+    uint32_t bufferCaps() const { return m_segments.caps(); }
+    void setBufferCaps(uint32_t caps);
+
+    const AsyncHttpSegmentedBuffer &segmentedBuffer() const { return m_segments; }
+    AsyncHttpSegmentedBuffer &&takeSegmentedBuffer() { return std::move(m_segments); }
+
     bool collectResponseHeaders() const { return m_collectResponseHeaders; }
     void setCollectResponseHeaders(bool collectResponseHeaders) { m_collectResponseHeaders = collectResponseHeaders; }
 
-    const std::map<std::string, std::string> &responseHeaders() const { return m_responseHeaders; }
-    std::map<std::string, std::string> &&takeResponseHeaders() { return std::move(m_responseHeaders); }
+    //! Only headers matching the filter are collected, an empty filter collects all of them
+    const AsyncHttpHeaderFilter &responseHeaderFilter() const { return m_responseHeaderFilter; }
+    void setResponseHeaderFilter(AsyncHttpHeaderFilter &&responseHeaderFilter) { m_responseHeaderFilter = std::move(responseHeaderFilter); }
+
+    //! Headers of the last response, names are matched case-insensitively, use toMap() for the old representation
+    const AsyncHttpHeaders &responseHeaders() const { return m_responseHeaders; }
+    AsyncHttpHeaders &&takeResponseHeaders() { return std::move(m_responseHeaders); }
+
+    //! Keeps the connection open after a request and reuses the client when start() targets the same origin,
+    //! serverCert and clientAuth have to be the very same buffers (not only equal contents) for that
+    bool keepAlive() const { return m_keepAlive; }
+    void setKeepAlive(bool keepAlive) { m_keepAlive = keepAlive; }
+
+    //! Clients are taken from and returned to AsyncHttpConnectionPool instead of being created and destroyed,
+    //! including on destruction of this instance. Off by default: a pooled client keeps pointing to the
+    //! serverCert and clientAuth it was created with, so those have to outlive the pool (which is the case
+    //! for static certificates)
+    bool usePool() const { return m_usePool; }
+    void setUsePool(bool usePool) { m_usePool = usePool; }
+
+    //! Returns the client to the pool as soon as a request finished so other instances can use the connection,
+    //! retry() is not possible then, start() has to be used instead
+    bool releaseAfterRequest() const { return m_releaseAfterRequest; }
+    void setReleaseAfterRequest(bool releaseAfterRequest) { m_releaseAfterRequest = releaseAfterRequest; }
+
+    //! Heap memory currently held by the buffers of this instance, split by internal and external ram
+    MemoryUsage memoryUsage() const;
+
+    //! How the connection of the last request was established, TlsSessionOffered does not mean the
+    //! server accepted the session, a refused one still costs a full handshake
+    Handshake handshake() const { return m_handshake; }
+    //! Time spent for dns, tcp connect and tls handshake of the last request
+    std::chrono::milliseconds handshakeDuration() const { return m_handshakeDuration; }
+
+    //! Requests that were sent over an already open connection
+    std::size_t reuseHits() const { return m_reuseHits; }
+    //! Requests that had to open a new connection
+    std::size_t reuseMisses() const { return m_reuseMisses; }
 
 private:
+    //! Either the owning map of start()/retry() or the views of startView()/retryView()
+    class RequestHeaders
+    {
+    public:
+        RequestHeaders() : m_map{} {}
+        RequestHeaders(const std::map<std::string, std::string> &map) : m_map{&map} {}
+        RequestHeaders(std::span<const HeaderView> views) : m_map{}, m_views{views} {}
+
+        bool contains(std::string_view key) const;
+
+        template<typename Callback>
+        std::expected<void, std::string> forEach(Callback &&callback) const
+        {
+            if (m_map)
+                for (const auto &[key, value] : *m_map)
+                    if (auto result = callback(key, value); !result)
+                        return result;
+
+            // esp_http_client keeps one value per name, repeated names are sent once with their values joined by ", "
+            for (auto iter = std::begin(m_views); iter != std::end(m_views); iter++)
+            {
+                const auto sameName = [&](const HeaderView &header){ return AsyncHttpHeaders::nameEquals(header.first, iter->first); };
+                if (std::any_of(std::begin(m_views), iter, sameName))
+                    continue;
+
+                auto repeated = std::find_if(std::next(iter), std::end(m_views), sameName);
+                if (repeated == std::end(m_views))
+                {
+                    if (auto result = callback(iter->first, iter->second); !result)
+                        return result;
+                    continue;
+                }
+
+                std::string joined{iter->second};
+                for (; repeated != std::end(m_views); repeated = std::find_if(std::next(repeated), std::end(m_views), sameName))
+                {
+                    joined += ", ";
+                    joined += repeated->second;
+                }
+                if (auto result = callback(iter->first, joined); !result)
+                    return result;
+            }
+
+            return {};
+        }
+
+    private:
+        const std::map<std::string, std::string> *m_map;
+        std::span<const HeaderView> m_views;
+    };
+
+    struct QueuedRequest
+    {
+        std::span<char> responseBuffer;
+        std::string url;
+        esp_http_client_method_t method;
+        std::vector<std::pair<std::string, std::string>> requestHeaders; // in order, repeated names included
+        std::string requestBody;
+        std::span<const std::byte> requestBodyView; // zero-copy variants only, owned by the caller
+        int timeout_ms;
+        // not copied, the client keeps pointing to the tls material after it was started anyway
+        std::string_view serverCert;
+        std::optional<cpputils::ClientAuth> clientAuth;
+        espchrono::millis_clock::time_point queuedAt;
+        Priority priority;
+        std::optional<espchrono::millis_clock::time_point> deadline;
+    };
+
+    //! Runs ensureTask() and locks m_startMutex, which has to be held from the busy() check until submitRequest()
+    std::expected<std::unique_lock<std::mutex>, std::string> lockStart();
+    //! Moves the request into the queue if another one is in progress, nullopt means start it now.
+    //! m_startMutex has to be held, so a concurrent start() cannot slip in between the check and startRequest()
+    std::optional<std::expected<void, std::string>> queueIfBusy(std::span<char> responseBuffer,
+                                                                std::string_view url,
+                                                                esp_http_client_method_t method,
+                                                                const RequestHeaders &requestHeaders,
+                                                                std::string &requestBody,
+                                                                std::span<const std::byte> requestBodyView, int timeout_ms,
+                                                                std::string_view serverCert,
+                                                                const std::optional<cpputils::ClientAuth> &clientAuth);
+    void startQueuedRequest();
+
+    //! start() without queueing for startAsync(), whose awaitable has to belong to the started request
+    std::expected<void, std::string> startNow(std::string_view url,
+                                              esp_http_client_method_t method = HTTP_METHOD_GET,
+                                              const std::map<std::string, std::string> &requestHeaders = {},
+                                              std::string &&requestBody = {}, int timeout_ms = 0,
+                                              std::string_view serverCert = {},
+                                              const std::optional<cpputils::ClientAuth> &clientAuth = {});
+    std::expected<void, std::string> startNow(const AsyncHttpPreparedRequest &prepared, std::string &&requestBody = {});
+
+    //! m_startMutex has to be held, see lockStart()
+    std::expected<void, std::string> startRequest(std::span<char> responseBuffer,
+                                                  std::string_view url,
+                                                  esp_http_client_method_t method,
+                                                  const RequestHeaders &requestHeaders,
+                                                  std::string &&requestBody,
+                                                  std::span<const std::byte> requestBodyView, int timeout_ms,
+                                                  std::string_view serverCert,
+                                                  const std::optional<cpputils::ClientAuth> &clientAuth);
+    std::expected<void, std::string> retryRequest(std::span<char> responseBuffer,
+                                                  std::optional<std::string_view> url,
+                                                  std::optional<esp_http_client_method_t> method,
+                                                  const RequestHeaders &requestHeaders,
+                                                  std::optional<std::string> &&requestBody,
+                                                  std::optional<std::span<const std::byte>> requestBodyView,
+                                                  std::optional<int> timeout_ms);
+    //! m_startMutex has to be held, see lockStart()
+    std::expected<void, std::string> startPrepared(std::span<char> responseBuffer,
+                                                   const AsyncHttpPreparedRequest &prepared,
+                                                   std::string &&requestBody,
+                                                   std::span<const std::byte> requestBodyView);
+
+    std::expected<void, std::string> createClient(std::optional<AsyncHttpOrigin> &&origin,
+                                                  std::string_view url, esp_http_client_method_t method, int timeout_ms,
+                                                  std::string_view serverCert,
+                                                  const std::optional<cpputils::ClientAuth> &clientAuth);
+    std::expected<void, std::string> reuseClient(std::string_view url, esp_http_client_method_t method, int timeout_ms,
+                                                 const RequestHeaders &requestHeaders);
+    std::expected<void, std::string> configureClient(std::string_view url, esp_http_client_method_t method, int timeout_ms);
+    void deleteRequestHeaders(const RequestHeaders &keep = {});
+    void releaseClient();
+    std::expected<void, std::string> setRequestHeaders(const RequestHeaders &requestHeaders);
+    //! The body is not copied by esp_http_client, it has to stay valid until the request finished
+    std::expected<void, std::string> setRequestBody(std::string_view body);
+    //! Copies an owned request body into m_requestBody, on the heap of bufferCaps()
+    void storeRequestBody(std::string_view body);
+
+    std::optional<std::size_t> bodyLimit() const;
+
+    std::expected<void, std::string> ensureTask();
+    void submitRequest();
+
+    //! Returns false if the deadline already passed, the request has to be finished right away
+    bool beginRequest();
+    bool pausedForInteractive() const;
+    std::optional<esp_err_t> performStep();
+    void beginConnect();
+    void finishRequest(esp_err_t result);
+    bool claimScheduledCycle();
+    void prepareScheduledRequest();
+    void finishScheduledRequest(esp_err_t result);
+    void notifyCompletion(esp_err_t result);
+    //! result() of the request that finished last, without checking whether one is running
+    std::expected<void, std::string> finishedResult() const;
+    //! inProgress(), except for the completion handlers of the finished request
+    bool busy() const;
+    //! The caller runs the completion handlers, the request is finished for them
+    bool completing(EventBits_t bits) const;
+
+    std::optional<espchrono::millis_clock::time_point> nextStepDue() const;
+    void step();
+
     esp_err_t httpEventHandler(esp_http_client_event_t *evt);
     static esp_err_t staticHttpEventHandler(esp_http_client_event_t *evt);
     static void requestTask(void *ptr);
     void requestTask();
 
     espcpputils::http_client m_client;
-    std::string m_buf;
+    AsyncHttpString m_buf;
     TaskHandle_t m_taskHandle{NULL};
     espcpputils::event_group m_eventGroup;
     esp_err_t m_result{};
     int m_statusCode{};
+    RequestTiming m_timing;
+    BodyStats m_bodyStats;
     std::size_t m_sizeLimit{4096};
     bool m_collectResponseHeaders{};
-    std::map<std::string, std::string> m_responseHeaders;
-    std::string m_requestBody;
+    bool m_progress{};
+    BodySink m_bodySink;
+    OversizePolicy m_oversizePolicy{};
+    bool m_spillToSink{};
+    std::optional<std::size_t> m_contentLength;
+    std::size_t m_rejectedLimit{};
+    esp_http_client_method_t m_method{HTTP_METHOD_GET};
+    bool m_segmented{};
+    AsyncHttpSegmentedBuffer m_segments;
+    std::span<char> m_responseBuffer;
+    std::size_t m_responseSize{};
+    esp_err_t m_bodyError{};
+    bool m_keepAlive{true};
+    bool m_usePool{};
+    bool m_releaseAfterRequest{};
+    bool m_connected{};
+    bool m_connectionReused{};
+    bool m_responseStarted{};
+    bool m_clientHasSession{};
+    Handshake m_handshake{};
+    std::chrono::milliseconds m_handshakeDuration{};
+    espchrono::millis_clock::time_point m_connectStarted{};
+    std::size_t m_reuseHits{};
+    std::size_t m_reuseMisses{};
+    std::optional<AsyncHttpOrigin> m_clientOrigin;
+    std::vector<std::string> m_requestHeaderKeys;
+    uint32_t m_preparedId{}; // template url, method, timeout and headers of m_client were set from
+    std::chrono::milliseconds m_pollInterval{};
+
+    AsyncHttpWorker * const m_worker{};
+    const bool m_polled{};
+    bool m_workerClaimed{}; // guarded by the worker mutex
+    espchrono::millis_clock::time_point m_nextPoll{};
+    AsyncHttpHeaders m_responseHeaders;
+    AsyncHttpHeaderFilter m_responseHeaderFilter;
+    AsyncHttpString m_requestBody;
+    std::size_t m_requestBodySize{}; // of the post field currently set on m_client
+    Schedule m_schedule;
+    ScheduleCallback m_scheduleCallback;
+    espchrono::millis_clock::time_point m_scheduleBase{}; // start of the current cycle without jitter
+    espchrono::millis_clock::time_point m_nextScheduled{};
+    bool m_scheduleHasPrevious{};
+    esp_err_t m_schedulePreviousResult{};
+    int m_schedulePreviousStatusCode{};
+    uint32_t m_schedulePreviousBodyHash{};
+    uint32_t m_bodyHash{}; // FNV-1a of the body, only computed while scheduled
+    CompletionCallback m_completionCallback;
+    bool m_postCompletionEvent{};
+    esp_event_loop_handle_t m_completionEventLoop{};
+    Priority m_priority{Priority::Normal};
+    std::optional<espchrono::millis_clock::time_point> m_deadline;
+    bool m_pauseForInteractive{};
+    Priority m_activePriority{Priority::Normal}; // of the submitted request
+    std::optional<espchrono::millis_clock::time_point> m_activeDeadline;
+    bool m_countedInteractive{};
+    bool m_dropped{};
+    std::mutex m_startMutex; // claims an idle instance, held from the inProgress() check until START_REQUEST_BIT is set
+    mutable std::mutex m_queueMutex;
+    std::deque<QueuedRequest> m_queue; // guarded by m_queueMutex
+    std::size_t m_queueCapacity{}; // guarded by m_queueMutex
+    QueueStats m_queueStats; // guarded by m_queueMutex
+    bool m_queueStarting{}; // guarded by m_queueMutex, a dequeued request is being started
+    std::atomic<void *> m_awaitingCoroutine{}; // address of the coroutine handle, resumed by whoever takes it
+    std::atomic<TaskHandle_t> m_completingTask{}; // runs the completion handlers of the finished request
+
+    UBaseType_t m_taskPriority{CONFIG_ASYNC_HTTP_TASK_PRIORITY};
+    bool m_persistentTask{};
+    const std::span<StackType_t> m_taskStack;
+    StaticTask_t * const m_taskBuffer{};
 
     const char * const m_taskName;
     const uint32_t m_taskSize;
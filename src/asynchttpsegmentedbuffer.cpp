@@ -0,0 +1,146 @@
+#include "asynchttpsegmentedbuffer.h"
+
+// system includes
+#include <algorithm>
+#include <iterator>
+#include <mutex>
+#include <utility>
+
+// esp-idf includes
+#include <esp_heap_caps.h>
+
+namespace {
+struct FreeSegment
+{
+    AsyncHttpSegmentedBuffer::SegmentPtr segment;
+    uint32_t caps;
+};
+
+std::mutex freeSegmentsMutex;
+std::vector<FreeSegment> freeSegments; // guarded by freeSegmentsMutex
+
+AsyncHttpSegmentedBuffer::SegmentPtr acquireSegment(uint32_t caps)
+{
+    {
+        std::lock_guard lock{freeSegmentsMutex};
+        // the most recently released one, still warm in the cache and erased without moving the others
+        if (const auto iter = std::find_if(std::rbegin(freeSegments), std::rend(freeSegments), [&](const FreeSegment &entry){ return entry.caps == caps; });
+            iter != std::rend(freeSegments))
+        {
+            auto segment = std::move(iter->segment);
+            freeSegments.erase(std::next(iter).base());
+            return segment;
+        }
+    }
+
+    return AsyncHttpSegmentedBuffer::SegmentPtr{(char *)heap_caps_malloc(AsyncHttpSegmentedBuffer::SegmentSize, caps)};
+}
+
+void releaseSegments(std::vector<AsyncHttpSegmentedBuffer::SegmentPtr> &segments, uint32_t caps)
+{
+    {
+        std::lock_guard lock{freeSegmentsMutex};
+        while (!segments.empty() && freeSegments.size() < CONFIG_ASYNC_HTTP_SEGMENT_POOL_SIZE)
+        {
+            // reserve() outside of the hot path, the free list never grows beyond its limit
+            if (freeSegments.capacity() < CONFIG_ASYNC_HTTP_SEGMENT_POOL_SIZE)
+                freeSegments.reserve(CONFIG_ASYNC_HTTP_SEGMENT_POOL_SIZE);
+            freeSegments.push_back(FreeSegment{ .segment = std::move(segments.back()), .caps = caps });
+            segments.pop_back();
+        }
+    }
+
+    segments.clear();
+}
+} // namespace
+
+AsyncHttpSegmentedBuffer::AsyncHttpSegmentedBuffer(uint32_t caps) :
+    m_caps{caps}
+{
+}
+
+AsyncHttpSegmentedBuffer::AsyncHttpSegmentedBuffer(AsyncHttpSegmentedBuffer &&other) :
+    m_segments{std::move(other.m_segments)},
+    m_size{std::exchange(other.m_size, 0)},
+    m_caps{other.m_caps}
+{
+}
+
+AsyncHttpSegmentedBuffer &AsyncHttpSegmentedBuffer::operator=(AsyncHttpSegmentedBuffer &&other)
+{
+    if (this != &other)
+    {
+        clear();
+        m_segments = std::move(other.m_segments);
+        m_size = std::exchange(other.m_size, 0);
+        m_caps = other.m_caps;
+    }
+    return *this;
+}
+
+AsyncHttpSegmentedBuffer::~AsyncHttpSegmentedBuffer()
+{
+    clear();
+}
+
+bool AsyncHttpSegmentedBuffer::append(std::string_view data)
+{
+    while (!data.empty())
+    {
+        if (m_size == m_segments.size() * SegmentSize)
+        {
+            auto segment = acquireSegment(m_caps);
+            if (!segment)
+                return false;
+            m_segments.push_back(std::move(segment));
+        }
+
+        const auto offset = m_size % SegmentSize;
+        const auto size = std::min(SegmentSize - offset, data.size());
+        std::copy_n(data.data(), size, m_segments.back().get() + offset);
+        m_size += size;
+        data.remove_prefix(size);
+    }
+
+    return true;
+}
+
+void AsyncHttpSegmentedBuffer::clear()
+{
+    releaseSegments(m_segments, m_caps);
+    m_size = 0;
+}
+
+void AsyncHttpSegmentedBuffer::setCaps(uint32_t caps)
+{
+    clear();
+    m_caps = caps;
+}
+
+std::span<const char> AsyncHttpSegmentedBuffer::segment(std::size_t index) const
+{
+    const auto offset = index * SegmentSize;
+    return {m_segments[index].get(), std::min(SegmentSize, m_size - offset)};
+}
+
+std::size_t AsyncHttpSegmentedBuffer::copyTo(std::span<char> destination) const
+{
+    std::size_t copied{};
+    for (const auto segment : *this)
+    {
+        const auto size = std::min(segment.size(), destination.size() - copied);
+        std::copy_n(segment.data(), size, destination.data() + copied);
+        copied += size;
+        if (copied == destination.size())
+            break;
+    }
+    return copied;
+}
+
+std::string AsyncHttpSegmentedBuffer::flatten() const
+{
+    std::string result;
+    result.resize(m_size);
+    copyTo(result);
+    return result;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "sdkconfig.h"
+
+// system includes
+#include <string>
+#include <string_view>
+#include <span>
+#include <vector>
+#include <memory>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
+
+// esp-idf includes
+#include <esp_heap_caps.h>
+
+//! Response buffer made of fixed size segments taken from a process-wide free list.
+//! Growing it never copies already received data and never needs more than one
+//! segment of contiguous memory, which matters on a fragmented heap.
+class AsyncHttpSegmentedBuffer
+{
+public:
+    static constexpr std::size_t SegmentSize = CONFIG_ASYNC_HTTP_SEGMENT_SIZE;
+
+    struct SegmentDeleter { void operator()(char *segment) const { heap_caps_free(segment); } };
+    using SegmentPtr = std::unique_ptr<char, SegmentDeleter>;
+
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::span<const char>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        const_iterator() = default;
+        const_iterator(const AsyncHttpSegmentedBuffer *buffer, std::size_t index) : m_buffer{buffer}, m_index{index} {}
+
+        value_type operator*() const { return m_buffer->segment(m_index); }
+        const_iterator &operator++() { m_index++; return *this; }
+        const_iterator operator++(int) { auto copy = *this; m_index++; return copy; }
+        bool operator==(const const_iterator &other) const = default;
+
+    private:
+        const AsyncHttpSegmentedBuffer *m_buffer{};
+        std::size_t m_index{};
+    };
+
+    //! caps select the heap segments are allocated from, e.g. MALLOC_CAP_SPIRAM
+    explicit AsyncHttpSegmentedBuffer(uint32_t caps = MALLOC_CAP_DEFAULT);
+    AsyncHttpSegmentedBuffer(AsyncHttpSegmentedBuffer &&other);
+    AsyncHttpSegmentedBuffer &operator=(AsyncHttpSegmentedBuffer &&other);
+    ~AsyncHttpSegmentedBuffer();
+
+    //! Returns false if no segment could be allocated, the data appended so far stays valid
+    bool append(std::string_view data);
+    //! Returns all segments to the free list
+    void clear();
+
+    uint32_t caps() const { return m_caps; }
+    //! Clears the buffer, following segments are allocated with the new caps
+    void setCaps(uint32_t caps);
+
+    std::size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    std::size_t segmentCount() const { return m_segments.size(); }
+    std::span<const char> segment(std::size_t index) const;
+
+    const_iterator begin() const { return {this, 0}; }
+    const_iterator end() const { return {this, m_segments.size()}; }
+
+    //! Copies as much as fits into destination, returns the number of bytes copied
+    std::size_t copyTo(std::span<char> destination) const;
+    //! Needs one contiguous allocation of size(), only use it when the consumer cannot handle segments
+    std::string flatten() const;
+
+private:
+    std::vector<SegmentPtr> m_segments;
+    std::size_t m_size{};
+    uint32_t m_caps;
+};
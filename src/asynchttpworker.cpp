@@ -0,0 +1,259 @@
+#include "asynchttpworker.h"
+
+#include "sdkconfig.h"
+#define LOG_LOCAL_LEVEL CONFIG_LOG_LOCAL_LEVEL_ASYNC_HTTP
+
+// system includes
+#include <chrono>
+#include <optional>
+#include <algorithm>
+#include <assert.h>
+
+// esp-idf includes
+#include <esp_log.h>
+
+// 3rdparty lib includes
+#include <fmt/core.h>
+#include <espchrono.h>
+#include <tickchrono.h>
+
+// local includes
+#include "asynchttprequest.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+constexpr const char * const TAG = "ASYNC_HTTP";
+
+constexpr int WAKEUP_BIT = BIT0;
+constexpr int END_TASKS_BIT = BIT1;
+constexpr int TASK_ENDED_BIT = BIT2;
+} // namespace
+
+AsyncHttpWorker::AsyncHttpWorker(const char *taskName, espcpputils::CoreAffinity coreAffinity, uint32_t taskSize, std::size_t taskCount) :
+    m_taskName{taskName},
+    m_taskSize{taskSize},
+    m_taskCount{std::max<std::size_t>(taskCount, 1)},
+    m_coreAffinity{coreAffinity}
+{
+    assert(m_eventGroup.handle);
+}
+
+AsyncHttpWorker::~AsyncHttpWorker()
+{
+    endTasks();
+
+    if (!m_requests.empty())
+        ESP_LOGE(TAG, "%s destroyed with %zu requests still attached", m_taskName, m_requests.size());
+}
+
+std::expected<void, std::string> AsyncHttpWorker::startTasks()
+{
+    std::lock_guard lock{m_mutex};
+
+    if (m_runningTasks)
+    {
+        constexpr auto msg = "http worker tasks already running";
+        ESP_LOGW(TAG, "%s", msg);
+        return std::unexpected(msg);
+    }
+
+    return startTasksLocked();
+}
+
+std::expected<void, std::string> AsyncHttpWorker::ensureTasks()
+{
+    // called by every request on submission, two of them may race for a fresh worker
+    std::lock_guard lock{m_mutex};
+
+    if (m_runningTasks)
+        return {};
+
+    return startTasksLocked();
+}
+
+std::expected<void, std::string> AsyncHttpWorker::startTasksLocked()
+{
+    m_eventGroup.clearBits(WAKEUP_BIT | END_TASKS_BIT | TASK_ENDED_BIT);
+
+    for (std::size_t i = 0; i < m_taskCount; i++)
+    {
+        m_runningTasks++;
+
+        TaskHandle_t taskHandle{NULL};
+        if (auto result = espcpputils::createTask(workerTask, m_taskName, m_taskSize, this, CONFIG_ASYNC_HTTP_TASK_PRIORITY, &taskHandle, m_coreAffinity);
+            result != pdPASS)
+        {
+            m_runningTasks--;
+
+            auto msg = fmt::format("failed creating http worker task {}", result);
+            ESP_LOGE(TAG, "%.*s", msg.size(), msg.data());
+
+            // the tasks created so far can still do the work
+            if (i == 0)
+                return std::unexpected(std::move(msg));
+            break;
+        }
+    }
+
+    ESP_LOGD(TAG, "created %zu http worker tasks %s", m_runningTasks.load(), m_taskName);
+
+    return {};
+}
+
+std::expected<void, std::string> AsyncHttpWorker::endTasks()
+{
+    if (!m_runningTasks)
+        return {};
+
+    m_eventGroup.setBits(END_TASKS_BIT);
+
+    // a task signals before it stops counting as running, the wakeup may come too early for the last one
+    while (m_runningTasks)
+        m_eventGroup.waitBits(TASK_ENDED_BIT, true, false, std::chrono::ceil<espcpputils::ticks>(10ms).count());
+
+    m_eventGroup.clearBits(END_TASKS_BIT);
+
+    ESP_LOGI(TAG, "http worker tasks %s ended", m_taskName);
+
+    return {};
+}
+
+bool AsyncHttpWorker::tasksRunning() const
+{
+    return m_runningTasks;
+}
+
+std::size_t AsyncHttpWorker::requestCount() const
+{
+    std::lock_guard lock{m_mutex};
+    return m_requests.size();
+}
+
+void AsyncHttpWorker::attach(AsyncHttpRequest &request)
+{
+    std::lock_guard lock{m_mutex};
+    m_requests.push_back(&request);
+}
+
+void AsyncHttpWorker::detach(AsyncHttpRequest &request)
+{
+    // a worker task might be inside request.step() right now
+    while (true)
+    {
+        {
+            std::lock_guard lock{m_mutex};
+            if (!request.m_workerClaimed)
+            {
+                std::erase(m_requests, &request);
+                return;
+            }
+        }
+
+        espcpputils::delay(10ms);
+    }
+}
+
+bool AsyncHttpWorker::higherPriority(const AsyncHttpRequest &a, const AsyncHttpRequest &b)
+{
+    // earliest deadline first within the same priority, equal ones keep the round robin order
+    if (a.m_activePriority != b.m_activePriority)
+        return a.m_activePriority > b.m_activePriority;
+    if (a.m_activeDeadline && b.m_activeDeadline)
+        return *a.m_activeDeadline < *b.m_activeDeadline;
+    return a.m_activeDeadline && !b.m_activeDeadline;
+}
+
+void AsyncHttpWorker::notify()
+{
+    m_eventGroup.setBits(WAKEUP_BIT);
+}
+
+void AsyncHttpWorker::workerTask(void *ptr)
+{
+    auto _this = reinterpret_cast<AsyncHttpWorker*>(ptr);
+
+    assert(_this);
+
+    _this->workerTask();
+}
+
+void AsyncHttpWorker::workerTask()
+{
+    ESP_LOGI(TAG, "%s worker task started", m_taskName);
+
+    while (!(m_eventGroup.getBits() & END_TASKS_BIT))
+    {
+        AsyncHttpRequest *request{};
+        std::optional<espchrono::millis_clock::time_point> nextDue;
+
+        {
+            std::lock_guard lock{m_mutex};
+
+            // cleared before scanning, so a request submitted meanwhile wakes us up again
+            m_eventGroup.clearBits(WAKEUP_BIT);
+
+            const auto now = espchrono::millis_clock::now();
+            bool moreReady{};
+
+            for (std::size_t i = 0; i < m_requests.size(); i++)
+            {
+                const auto index = (m_nextIndex + i) % m_requests.size();
+                auto * const candidate = m_requests[index];
+                if (candidate->m_workerClaimed)
+                    continue;
+
+                const auto due = candidate->nextStepDue();
+                if (!due)
+                    continue;
+
+                if (*due <= now)
+                {
+                    if (!request || higherPriority(*candidate, *request))
+                    {
+                        if (request)
+                            moreReady = true;
+                        request = candidate;
+                        m_nextIndex = (index + 1) % m_requests.size();
+                    }
+                    else
+                        moreReady = true;
+                }
+                else if (!nextDue || *due < *nextDue)
+                    nextDue = *due;
+            }
+
+            if (request)
+                request->m_workerClaimed = true;
+
+            // let the other worker tasks pick up the remaining ones
+            if (moreReady)
+                m_eventGroup.setBits(WAKEUP_BIT);
+        }
+
+        if (request)
+        {
+            request->step();
+
+            std::lock_guard lock{m_mutex};
+            request->m_workerClaimed = false;
+            continue;
+        }
+
+        TickType_t timeout = portMAX_DELAY;
+        if (nextDue)
+        {
+            const std::chrono::milliseconds remaining = *nextDue - espchrono::millis_clock::now();
+            timeout = remaining > 0ms ? std::chrono::ceil<espcpputils::ticks>(remaining).count() : 1;
+        }
+
+        m_eventGroup.waitBits(WAKEUP_BIT | END_TASKS_BIT, false, false, timeout);
+    }
+
+    ESP_LOGI(TAG, "%s worker task ended", m_taskName);
+
+    // endTasks() may destroy the worker as soon as m_runningTasks dropped, nothing touches it afterwards
+    m_eventGroup.setBits(TASK_ENDED_BIT);
+    m_runningTasks--;
+    vTaskDelete(NULL);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+// system includes
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <expected>
+
+// esp-idf includes
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// 3rdparty lib includes
+#include <wrappers/event_group.h>
+#include <taskutils.h>
+
+class AsyncHttpRequest;
+
+//! Drives any number of AsyncHttpRequest instances from a fixed set of tasks
+//! instead of one task per request. Requests attach themselves on construction.
+class AsyncHttpWorker
+{
+    friend class AsyncHttpRequest;
+
+public:
+    AsyncHttpWorker(const char *taskName="httpWorkerTask", espcpputils::CoreAffinity coreAffinity=espcpputils::CoreAffinity::Core1,
+                    uint32_t taskSize = 4096, std::size_t taskCount = 1);
+    ~AsyncHttpWorker();
+
+    std::expected<void, std::string> startTasks();
+    std::expected<void, std::string> endTasks();
+    bool tasksRunning() const;
+
+    std::size_t requestCount() const;
+
+private:
+    void attach(AsyncHttpRequest &request);
+    void detach(AsyncHttpRequest &request);
+    void notify();
+    std::expected<void, std::string> ensureTasks();
+    std::expected<void, std::string> startTasksLocked(); // m_mutex has to be held
+    static bool higherPriority(const AsyncHttpRequest &a, const AsyncHttpRequest &b);
+
+    static void workerTask(void *ptr);
+    void workerTask();
+
+    mutable std::mutex m_mutex;
+    std::vector<AsyncHttpRequest*> m_requests; // guarded by m_mutex
+    std::size_t m_nextIndex{}; // guarded by m_mutex, round robin start
+    std::atomic<std::size_t> m_runningTasks{};
+    espcpputils::event_group m_eventGroup;
+
+    const char * const m_taskName;
+    const uint32_t m_taskSize;
+    const std::size_t m_taskCount;
+    const espcpputils::CoreAffinity m_coreAffinity;
+};
@@ -0,0 +1,113 @@
+// system includes
+#include <coroutine>
+#include <exception>
+#include <expected>
+#include <optional>
+#include <string>
+
+// 3rdparty lib includes
+#include <gtest/gtest.h>
+
+// local includes
+#include "asynchttpawaitable.h"
+#include "asynchttprequest.h"
+#include "loopbackserver.h"
+#include "testutils.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+//! Coroutine that runs until its first suspension right away and is never awaited itself
+struct Detached
+{
+    struct promise_type
+    {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+using AwaitResult = std::expected<AsyncHttpResponse, AsyncHttpError>;
+
+Detached fetch(AsyncHttpRequest &request, std::string url, std::optional<AwaitResult> &response)
+{
+    response = co_await request.startAsync(url);
+}
+
+void expectResponse(const std::optional<AwaitResult> &response)
+{
+    ASSERT_TRUE(response) << "the coroutine was not resumed";
+    ASSERT_TRUE(*response) << (*response).error().message;
+    EXPECT_EQ((*response)->statusCode, 200);
+    EXPECT_EQ(std::string_view{(*response)->body}, LoopbackServer::pattern(100));
+}
+} // namespace
+
+TEST(AsyncHttpAwaitable, ResumesWithTheResponsePolled)
+{
+    test::HeldServer server;
+    AsyncHttpRequest request{AsyncHttpRequest::Polled{}, "testAwaitable"};
+
+    std::optional<AwaitResult> response;
+    fetch(request, server.url(), response);
+    ASSERT_FALSE(response) << "co_await did not suspend";
+
+    server.release();
+    ASSERT_TRUE(test::pollUntil(request, [&] { return response.has_value(); }));
+    expectResponse(response);
+}
+
+TEST(AsyncHttpAwaitable, ResumesWithTheResponseInTheTask)
+{
+    test::HeldServer server;
+    AsyncHttpRequest request{"testAwaitable"};
+
+    std::optional<AwaitResult> response;
+    fetch(request, server.url(), response);
+    ASSERT_FALSE(response) << "co_await did not suspend";
+
+    server.release();
+    // the coroutine has run to its end once the request counts as finished
+    ASSERT_TRUE(request.waitFinished(10s));
+    expectResponse(response);
+}
+
+TEST(AsyncHttpAwaitable, ResumesWithTheError)
+{
+    // nothing listens on the port of a server that is gone
+    std::string url;
+    {
+        LoopbackServer server;
+        url = server.url("/bytes/100");
+    }
+
+    AsyncHttpRequest request{AsyncHttpRequest::Polled{}, "testAwaitable"};
+
+    std::optional<AwaitResult> response;
+    fetch(request, url, response);
+    ASSERT_FALSE(response) << "co_await did not suspend";
+
+    ASSERT_TRUE(test::pollUntil(request, [&] { return response.has_value(); }));
+    ASSERT_FALSE(*response);
+    EXPECT_NE((*response).error().code, ESP_OK);
+    EXPECT_NE((*response).error().message, "request still running");
+}
+
+TEST(AsyncHttpAwaitable, FailsWhileAnotherRequestIsInProgress)
+{
+    test::HeldServer server;
+    AsyncHttpRequest request{AsyncHttpRequest::Polled{}, "testAwaitable"};
+
+    ASSERT_TRUE(request.start(server.url()));
+
+    std::optional<AwaitResult> response;
+    fetch(request, server.url(), response);
+    ASSERT_TRUE(response) << "a failed start suspended";
+    EXPECT_FALSE(*response);
+
+    server.release();
+    ASSERT_TRUE(test::pollUntil(request, [&] { return request.finished(); }));
+}
@@ -0,0 +1,133 @@
+// system includes
+#include <expected>
+#include <future>
+#include <string>
+
+// 3rdparty lib includes
+#include <gtest/gtest.h>
+
+// local includes
+#include "asynchttprequest.h"
+#include "loopbackserver.h"
+#include "testutils.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+//! What the completion callback could see of its request
+struct Seen
+{
+    int calls{};
+    bool finished{};
+    std::expected<void, std::string> result;
+    esp_err_t error{};
+    int statusCode{};
+    std::string body;
+};
+
+void record(Seen &seen, AsyncHttpRequest &request, esp_err_t result)
+{
+    seen.calls++;
+    seen.finished = request.finished();
+    seen.result = request.result();
+    seen.error = result;
+    seen.statusCode = request.statusCode();
+    seen.body = request.buffer();
+}
+} // namespace
+
+TEST(AsyncHttpCompletion, CallbackSeesTheFinishedRequest)
+{
+    LoopbackServer server;
+    AsyncHttpRequest request{AsyncHttpRequest::Polled{}, "testCompletion"};
+
+    Seen seen;
+    request.setCompletionCallback([&](AsyncHttpRequest &request, esp_err_t result) { record(seen, request, result); });
+
+    ASSERT_TRUE(request.start(server.url("/bytes/100")));
+    ASSERT_TRUE(test::pollUntil(request, [&] { return request.finished(); }));
+
+    EXPECT_EQ(seen.calls, 1);
+    EXPECT_TRUE(seen.finished);
+    EXPECT_TRUE(seen.result) << seen.result.error();
+    EXPECT_EQ(seen.error, ESP_OK);
+    EXPECT_EQ(seen.statusCode, 200);
+    EXPECT_EQ(seen.body, LoopbackServer::pattern(100));
+}
+
+TEST(AsyncHttpCompletion, CallbackSeesTheFailure)
+{
+    std::string url;
+    {
+        LoopbackServer server;
+        url = server.url("/bytes/100");
+    }
+
+    AsyncHttpRequest request{AsyncHttpRequest::Polled{}, "testCompletion"};
+
+    Seen seen;
+    request.setCompletionCallback([&](AsyncHttpRequest &request, esp_err_t result) { record(seen, request, result); });
+
+    ASSERT_TRUE(request.start(url));
+    ASSERT_TRUE(test::pollUntil(request, [&] { return request.finished(); }));
+
+    EXPECT_EQ(seen.calls, 1);
+    EXPECT_TRUE(seen.finished);
+    ASSERT_FALSE(seen.result);
+    EXPECT_TRUE(seen.result.error().starts_with("http request failed")) << seen.result.error();
+    EXPECT_NE(seen.error, ESP_OK);
+}
+
+TEST(AsyncHttpCompletion, OtherTasksSeeFinishedOnceTheCallbackReturned)
+{
+    LoopbackServer server;
+    AsyncHttpRequest request{"testCompletion"};
+
+    std::promise<void> entered;
+    std::promise<void> release;
+    Seen seen;
+    request.setCompletionCallback([&](AsyncHttpRequest &request, esp_err_t result) {
+        record(seen, request, result);
+        entered.set_value();
+        release.get_future().wait();
+    });
+
+    ASSERT_TRUE(request.start(server.url("/bytes/100")));
+    ASSERT_EQ(entered.get_future().wait_for(10s), std::future_status::ready);
+
+    EXPECT_FALSE(request.finished());
+    EXPECT_FALSE(request.result());
+    EXPECT_FALSE(request.start(server.url("/bytes/100"))) << "another task started a request inside the callback";
+
+    release.set_value();
+    ASSERT_TRUE(request.waitFinished(10s));
+
+    EXPECT_TRUE(seen.finished);
+    EXPECT_TRUE(seen.result) << seen.result.error();
+    EXPECT_TRUE(request.result());
+}
+
+TEST(AsyncHttpCompletion, CallbackStartsTheNextRequest)
+{
+    LoopbackServer server;
+    AsyncHttpRequest request{AsyncHttpRequest::Polled{}, "testCompletion"};
+
+    int calls{};
+    bool startedNext{};
+    bool finishedAfterStart{true};
+    request.setCompletionCallback([&](AsyncHttpRequest &request, esp_err_t result) {
+        if (++calls > 1)
+            return;
+        startedNext = bool(request.start(server.url("/bytes/200")));
+        // from here on the callback looks at the next request
+        finishedAfterStart = request.finished();
+    });
+
+    ASSERT_TRUE(request.start(server.url("/bytes/100")));
+    ASSERT_TRUE(test::pollUntil(request, [&] { return request.finished(); }));
+
+    EXPECT_TRUE(startedNext);
+    EXPECT_FALSE(finishedAfterStart);
+    EXPECT_EQ(calls, 2);
+    EXPECT_EQ(std::string_view{request.buffer()}, LoopbackServer::pattern(200));
+}
@@ -0,0 +1,20 @@
+// system includes
+#include <csignal>
+
+// esp-idf includes
+#include <esp_log.h>
+
+// 3rdparty lib includes
+#include <gtest/gtest.h>
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+
+    esp_log_level_set("*", ESP_LOG_WARN);
+
+    // the loopback server writes to connections the client may already have closed
+    std::signal(SIGPIPE, SIG_IGN);
+
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,125 @@
+// system includes
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 3rdparty lib includes
+#include <gtest/gtest.h>
+
+// local includes
+#include "asynchttprequest.h"
+#include "loopbackserver.h"
+#include "testutils.h"
+
+using namespace std::chrono_literals;
+
+TEST(AsyncHttpQueue, StartsQueuedRequestsInOrder)
+{
+    test::HeldServer server;
+    AsyncHttpRequest request{AsyncHttpRequest::Polled{}, "testQueue"};
+    request.setQueueCapacity(2);
+
+    std::vector<std::string> bodies;
+    request.setCompletionCallback([&](AsyncHttpRequest &request, esp_err_t result) { bodies.emplace_back(request.buffer()); });
+
+    ASSERT_TRUE(request.start(server.url(100)));
+    ASSERT_TRUE(request.start(server.url(200)));
+    ASSERT_TRUE(request.start(server.url(300)));
+    EXPECT_EQ(request.queueDepth(), 2);
+
+    server.release();
+    ASSERT_TRUE(test::pollUntil(request, [&] { return bodies.size() == 3; }));
+
+    EXPECT_EQ(bodies[0], LoopbackServer::pattern(100));
+    EXPECT_EQ(bodies[1], LoopbackServer::pattern(200));
+    EXPECT_EQ(bodies[2], LoopbackServer::pattern(300));
+
+    const auto stats = request.queueStats();
+    EXPECT_EQ(stats.depth, 0);
+    EXPECT_EQ(stats.maxDepth, 2);
+    EXPECT_EQ(stats.enqueued, 2);
+    EXPECT_EQ(stats.dequeued, 2);
+    EXPECT_EQ(stats.rejected, 0);
+}
+
+TEST(AsyncHttpQueue, RejectsWhenFull)
+{
+    test::HeldServer server;
+    AsyncHttpRequest request{AsyncHttpRequest::Polled{}, "testQueue"};
+
+    ASSERT_TRUE(request.start(server.url()));
+
+    // without a queue the old behaviour
+    auto result = request.start(server.url());
+    ASSERT_FALSE(result);
+    EXPECT_EQ(result.error(), "another request still in progress");
+
+    request.setQueueCapacity(1);
+    ASSERT_TRUE(request.start(server.url()));
+    result = request.start(server.url());
+    ASSERT_FALSE(result);
+    EXPECT_EQ(result.error(), "request queue full");
+    EXPECT_EQ(request.queueStats().rejected, 2);
+
+    server.release();
+    ASSERT_TRUE(test::pollUntil(request, [&] { return request.finished() && !request.queueDepth(); }));
+}
+
+TEST(AsyncHttpQueue, QueuesConcurrentStartsOnAnIdleInstance)
+{
+    constexpr int THREADS = 4;
+
+    test::HeldServer server;
+
+    // the busy check and the enqueue used to race with a start() of another task
+    for (int round = 0; round < 50; round++)
+    {
+        AsyncHttpRequest request{AsyncHttpRequest::Polled{}, "testQueue"};
+        request.setQueueCapacity(THREADS);
+
+        std::atomic<int> ready{};
+        std::atomic<int> failed{};
+        std::vector<std::thread> threads;
+        for (int i = 0; i < THREADS; i++)
+            threads.emplace_back([&] {
+                ready++;
+                while (ready < THREADS);
+                if (!request.start(server.url()))
+                    failed++;
+            });
+        for (auto &thread : threads)
+            thread.join();
+
+        ASSERT_EQ(failed, 0) << "round " << round;
+        EXPECT_EQ(request.queueDepth(), THREADS - 1);
+        request.clearQueue();
+        ASSERT_TRUE(request.abort());
+        ASSERT_TRUE(test::pollUntil(request, [&] { return request.finished(); }));
+    }
+
+    server.release();
+}
+
+TEST(AsyncHttpQueue, KeepsRepeatedHeaderNames)
+{
+    test::HeldServer heldServer;
+    // answers with the X-Test header the request arrived with
+    LoopbackServer server{[](const LoopbackServer::Request &request, LoopbackServer::Connection &connection) {
+        return LoopbackServer::respond(request, connection, 200, request.header("X-Test"));
+    }};
+
+    AsyncHttpRequest request{AsyncHttpRequest::Polled{}, "testQueue"};
+    request.setQueueCapacity(1);
+
+    ASSERT_TRUE(request.start(heldServer.url()));
+
+    const AsyncHttpRequest::HeaderView headers[] { { "X-Test", "a" }, { "X-Other", "c" }, { "x-test", "b" } };
+    ASSERT_TRUE(request.startView(server.url("/echo"), HTTP_METHOD_GET, headers));
+    EXPECT_EQ(request.queueDepth(), 1);
+
+    heldServer.release();
+    ASSERT_TRUE(test::pollUntil(request, [&] { return request.finished() && !request.queueDepth(); }));
+    ASSERT_TRUE(request.result());
+    EXPECT_EQ(std::string_view{request.buffer()}, "a, b");
+}
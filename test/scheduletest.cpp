@@ -0,0 +1,137 @@
+// system includes
+#include <atomic>
+#include <string>
+#include <vector>
+
+// 3rdparty lib includes
+#include <gtest/gtest.h>
+
+// local includes
+#include "asynchttprequest.h"
+#include "loopbackserver.h"
+#include "testutils.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+//! Counts requests, the body is the count divided by bodyDivisor (1 changes it every time)
+class CountingServer
+{
+public:
+    explicit CountingServer(int bodyDivisor = 1) :
+        m_server{[this, bodyDivisor](const LoopbackServer::Request &request, LoopbackServer::Connection &connection) {
+            const auto count = ++m_requests;
+            return LoopbackServer::respond(request, connection, 200, std::to_string(count / bodyDivisor));
+        }}
+    {}
+
+    std::string url() const { return m_server.url("/count"); }
+    int requests() const { return m_requests; }
+
+private:
+    std::atomic<int> m_requests{};
+    LoopbackServer m_server;
+};
+
+//! Finishes a first request, the schedule repeats it
+void startFirst(AsyncHttpRequest &request, const std::string &url)
+{
+    ASSERT_TRUE(request.start(url));
+    ASSERT_TRUE(test::pollUntil(request, [&] { return request.finished(); }));
+    ASSERT_TRUE(request.result());
+}
+} // namespace
+
+TEST(AsyncHttpSchedule, RepeatsTheRequestAndReportsChanges)
+{
+    CountingServer server;
+    AsyncHttpRequest request{AsyncHttpRequest::Polled{}, "testSchedule"};
+    startFirst(request, server.url());
+
+    std::vector<std::string> bodies;
+    ASSERT_TRUE(request.startSchedule({ .interval = 10ms }, [&](const AsyncHttpRequest &request, esp_err_t result) {
+        EXPECT_EQ(result, ESP_OK);
+        bodies.emplace_back(request.buffer());
+    }));
+    EXPECT_TRUE(request.scheduled());
+
+    ASSERT_TRUE(test::pollUntil(request, [&] { return bodies.size() >= 3; }));
+    request.stopSchedule();
+    ASSERT_TRUE(test::pollUntil(request, [&] { return !request.inProgress(); }));
+
+    EXPECT_FALSE(request.scheduled());
+    EXPECT_EQ(bodies[0], "2");
+    EXPECT_EQ(bodies[1], "3");
+    EXPECT_EQ(bodies[2], "4");
+}
+
+TEST(AsyncHttpSchedule, SkipsUnchangedResponses)
+{
+    // the body changes every third request
+    CountingServer server{3};
+    AsyncHttpRequest request{AsyncHttpRequest::Polled{}, "testSchedule"};
+    startFirst(request, server.url());
+
+    int calls{};
+    ASSERT_TRUE(request.startSchedule({ .interval = 5ms }, [&](const AsyncHttpRequest &request, esp_err_t result) { calls++; }));
+
+    ASSERT_TRUE(test::pollUntil(request, [&] { return server.requests() >= 10; }));
+    request.stopSchedule();
+    ASSERT_TRUE(test::pollUntil(request, [&] { return !request.inProgress(); }));
+
+    // the first cycle always reports, then one for every third request
+    const int cycles = server.requests() - 1;
+    EXPECT_GE(calls, 1 + (cycles - 2) / 3);
+    EXPECT_LE(calls, 1 + cycles / 3 + 1);
+    EXPECT_LT(calls, cycles);
+}
+
+TEST(AsyncHttpSchedule, NotifiesUnchangedResponsesOnRequest)
+{
+    CountingServer server{1000};
+    AsyncHttpRequest request{AsyncHttpRequest::Polled{}, "testSchedule"};
+    startFirst(request, server.url());
+
+    int calls{};
+    ASSERT_TRUE(request.startSchedule({ .interval = 5ms, .notifyUnchanged = true },
+                                      [&](const AsyncHttpRequest &request, esp_err_t result) { calls++; }));
+
+    ASSERT_TRUE(test::pollUntil(request, [&] { return calls >= 3; }));
+    request.stopSchedule();
+    ASSERT_TRUE(test::pollUntil(request, [&] { return !request.inProgress(); }));
+    EXPECT_EQ(calls, server.requests() - 1);
+}
+
+TEST(AsyncHttpSchedule, RunsFromTheRequestTask)
+{
+    CountingServer server;
+    AsyncHttpRequest request{"testSchedule"};
+    ASSERT_TRUE(request.start(server.url()));
+    ASSERT_TRUE(request.waitFinished(10s));
+
+    std::atomic<int> calls{};
+    ASSERT_TRUE(request.startSchedule({ .interval = 10ms }, [&](const AsyncHttpRequest &request, esp_err_t result) { calls++; }));
+
+    const auto deadline = espchrono::millis_clock::now() + 10s;
+    while (calls < 3 && espchrono::millis_clock::now() < deadline)
+        vTaskDelay(1);
+    request.stopSchedule();
+
+    EXPECT_GE(calls, 3);
+}
+
+TEST(AsyncHttpSchedule, RejectsInvalidSchedules)
+{
+    CountingServer server;
+    AsyncHttpRequest request{AsyncHttpRequest::Polled{}, "testSchedule"};
+
+    EXPECT_EQ(request.startSchedule({ .interval = 10ms }, {}).error(), "http client is null");
+
+    startFirst(request, server.url());
+    EXPECT_EQ(request.startSchedule({ .interval = 0ms }, {}).error(), "schedule interval has to be positive");
+
+    ASSERT_TRUE(request.startSchedule({ .interval = 1s }, {}));
+    EXPECT_EQ(request.startSchedule({ .interval = 1s }, {}).error(), "schedule already running");
+    request.stopSchedule();
+    ASSERT_TRUE(test::pollUntil(request, [&] { return !request.inProgress(); }));
+}
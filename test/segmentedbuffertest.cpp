@@ -0,0 +1,135 @@
+// system includes
+#include <array>
+#include <string>
+#include <utility>
+
+// 3rdparty lib includes
+#include <gtest/gtest.h>
+
+// local includes
+#include "asynchttprequest.h"
+#include "asynchttpsegmentedbuffer.h"
+#include "loopbackserver.h"
+#include "testutils.h"
+
+namespace {
+constexpr auto SegmentSize = AsyncHttpSegmentedBuffer::SegmentSize;
+} // namespace
+
+TEST(AsyncHttpSegmentedBuffer, AppendsAcrossSegments)
+{
+    const auto data = LoopbackServer::pattern(2 * SegmentSize + 10);
+
+    AsyncHttpSegmentedBuffer buffer;
+    ASSERT_TRUE(buffer.append(std::string_view{data}.substr(0, 10)));
+    ASSERT_TRUE(buffer.append(std::string_view{data}.substr(10)));
+
+    EXPECT_EQ(buffer.size(), data.size());
+    ASSERT_EQ(buffer.segmentCount(), 3);
+    EXPECT_EQ(buffer.segment(0).size(), SegmentSize);
+    EXPECT_EQ(buffer.segment(2).size(), 10);
+
+    std::string joined;
+    for (const auto segment : buffer)
+        joined.append(segment.data(), segment.size());
+    EXPECT_EQ(joined, data);
+    EXPECT_EQ(buffer.flatten(), data);
+}
+
+TEST(AsyncHttpSegmentedBuffer, CopiesAsMuchAsFits)
+{
+    const auto data = LoopbackServer::pattern(SegmentSize + 100);
+
+    AsyncHttpSegmentedBuffer buffer;
+    ASSERT_TRUE(buffer.append(data));
+
+    std::array<char, SegmentSize + 50> destination{};
+    EXPECT_EQ(buffer.copyTo(destination), destination.size());
+    EXPECT_EQ(std::string_view(destination.data(), destination.size()), std::string_view{data}.substr(0, destination.size()));
+}
+
+TEST(AsyncHttpSegmentedBuffer, ReusesSegmentsAfterClear)
+{
+    AsyncHttpSegmentedBuffer buffer;
+    ASSERT_TRUE(buffer.append(LoopbackServer::pattern(10)));
+    const auto *segment = buffer.segment(0).data();
+
+    buffer.clear();
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(buffer.segmentCount(), 0);
+
+    // taken back from the free list
+    ASSERT_TRUE(buffer.append(LoopbackServer::pattern(10)));
+    EXPECT_EQ(buffer.segment(0).data(), segment);
+}
+
+TEST(AsyncHttpSegmentedBuffer, MovesWithoutCopying)
+{
+    AsyncHttpSegmentedBuffer buffer;
+    ASSERT_TRUE(buffer.append(LoopbackServer::pattern(SegmentSize + 1)));
+    const auto *segment = buffer.segment(0).data();
+
+    AsyncHttpSegmentedBuffer moved{std::move(buffer)};
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(moved.size(), SegmentSize + 1);
+    EXPECT_EQ(moved.segment(0).data(), segment);
+}
+
+TEST(AsyncHttpSegmentedBuffer, CollectsTheResponseBody)
+{
+    LoopbackServer server;
+    AsyncHttpRequest request{AsyncHttpRequest::Polled{}, "testSegmented"};
+    request.setSegmented(true);
+    request.setSizeLimit(16 * SegmentSize);
+
+    const auto size = 5 * SegmentSize + 123;
+    ASSERT_TRUE(request.start(server.url("/bytes/" + std::to_string(size))));
+    ASSERT_TRUE(test::pollUntil(request, [&] { return request.finished(); }));
+    ASSERT_TRUE(request.result());
+
+    EXPECT_TRUE(request.buffer().empty());
+    EXPECT_EQ(request.responseSize(), size);
+    EXPECT_EQ(request.segmentedBuffer().segmentCount(), 6);
+    EXPECT_EQ(request.segmentedBuffer().flatten(), LoopbackServer::pattern(size));
+}
+
+TEST(AsyncHttpSegmentedBuffer, AppliesTheSizeLimit)
+{
+    // without a Content-Length, the limit can only be checked while the body arrives
+    LoopbackServer server{[](const LoopbackServer::Request &request, LoopbackServer::Connection &connection) {
+        return connection.send("HTTP/1.1 200 OK\r\nConnection: close\r\n\r\n") &&
+               connection.send(LoopbackServer::pattern(4 * SegmentSize)) && false;
+    }};
+
+    AsyncHttpRequest request{AsyncHttpRequest::Polled{}, "testSegmented"};
+    request.setSegmented(true);
+    request.setSizeLimit(2 * SegmentSize);
+
+    ASSERT_TRUE(request.start(server.url("/close")));
+    ASSERT_TRUE(test::pollUntil(request, [&] { return request.finished(); }));
+    ASSERT_FALSE(request.result());
+    EXPECT_EQ(request.result().error(), "http request failed: ESP_ERR_NO_MEM");
+    EXPECT_EQ(request.segmentedBuffer().size(), 2 * SegmentSize);
+}
+
+TEST(AsyncHttpBufferCaps, ApplyToEveryBufferOfTheResponse)
+{
+    LoopbackServer server;
+    AsyncHttpRequest request{AsyncHttpRequest::Polled{}, "testBufferCaps"};
+    request.setCollectResponseHeaders(true);
+    request.setBufferCaps(MALLOC_CAP_SPIRAM);
+
+    ASSERT_TRUE(request.start(server.url("/bytes/1000"), HTTP_METHOD_GET, {}, std::string(100, 'x')));
+    ASSERT_TRUE(test::pollUntil(request, [&] { return request.finished(); }));
+    ASSERT_TRUE(request.result());
+
+    EXPECT_EQ(request.bufferCaps(), MALLOC_CAP_SPIRAM);
+    EXPECT_EQ(request.buffer().get_allocator().caps(), MALLOC_CAP_SPIRAM);
+    EXPECT_EQ(request.responseHeaders().caps(), MALLOC_CAP_SPIRAM);
+    EXPECT_EQ(request.takeBuffer().size(), 1000);
+
+    // the host has no external ram, everything is accounted as internal
+    const auto usage = request.memoryUsage();
+    EXPECT_GE(usage.internal, 100 + request.responseHeaders().allocatedBytes());
+    EXPECT_EQ(usage.external, 0);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+// system includes
+#include <chrono>
+#include <functional>
+#include <future>
+#include <string>
+#include <thread>
+
+// local includes
+#include "asynchttprequest.h"
+#include "loopbackserver.h"
+
+namespace test {
+//! Polls request until done() returns true, false if that takes longer than timeout
+inline bool pollUntil(AsyncHttpRequest &request, const std::function<bool()> &done,
+                      std::chrono::milliseconds timeout = std::chrono::seconds{10})
+{
+    const auto deadline = espchrono::millis_clock::now() + timeout;
+    while (!done())
+    {
+        if (espchrono::millis_clock::now() > deadline)
+            return false;
+
+        request.poll();
+
+        // nothing due while idle, done() might be waiting for another thread
+        const auto due = request.nextPollDue().value_or(espchrono::millis_clock::now() + std::chrono::milliseconds{1});
+        std::this_thread::sleep_for(std::min(due, deadline) - espchrono::millis_clock::now());
+    }
+    return true;
+}
+
+//! Answers GET /bytes/<n> like the default LoopbackServer, but only once released,
+//! a request started before is certain to be in progress until then
+class HeldServer
+{
+public:
+    HeldServer() :
+        m_released{m_release.get_future().share()},
+        m_server{[released = m_released](const LoopbackServer::Request &request, LoopbackServer::Connection &connection) {
+            released.wait();
+            return LoopbackServer::respondBytes(request, connection, std::stoul(request.target.substr(7)));
+        }}
+    {}
+
+    std::string url(std::size_t size = 100) const { return m_server.url("/bytes/" + std::to_string(size)); }
+    void release() { m_release.set_value(); }
+
+private:
+    std::promise<void> m_release;
+    std::shared_future<void> m_released;
+    LoopbackServer m_server;
+};
+} // namespace test
@@ -0,0 +1,105 @@
+// system includes
+#include <array>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+
+// 3rdparty lib includes
+#include <gtest/gtest.h>
+
+// local includes
+#include "asynchttprequest.h"
+#include "loopbackserver.h"
+#include "testutils.h"
+
+namespace {
+//! Answers with "<method> <X-Test header> <body>" of the request, GET /bytes/<n> as usual
+LoopbackServer echoServer()
+{
+    return LoopbackServer{[](const LoopbackServer::Request &request, LoopbackServer::Connection &connection) {
+        if (request.target.starts_with("/bytes/"))
+            return LoopbackServer::respondBytes(request, connection, std::stoul(request.target.substr(7)));
+        return LoopbackServer::respond(request, connection, 200,
+                                       request.method + " " + std::string{request.header("X-Test")} + " " + request.body);
+    }};
+}
+
+std::span<const std::byte> bytes(std::string_view text)
+{
+    return std::as_bytes(std::span{text});
+}
+
+bool finish(AsyncHttpRequest &request)
+{
+    return test::pollUntil(request, [&] { return request.finished(); });
+}
+} // namespace
+
+TEST(AsyncHttpViews, SendsHeadersAndBody)
+{
+    auto server = echoServer();
+    AsyncHttpRequest request{AsyncHttpRequest::Polled{}, "testViews"};
+
+    const AsyncHttpRequest::HeaderView headers[] { { "X-Test", "a" } };
+    ASSERT_TRUE(request.startView(server.url("/echo"), HTTP_METHOD_POST, headers, bytes("hello")));
+    ASSERT_TRUE(finish(request));
+    ASSERT_TRUE(request.result());
+    EXPECT_EQ(std::string_view{request.buffer()}, "POST a hello");
+}
+
+TEST(AsyncHttpViews, RetryReplacesHeadersAndBody)
+{
+    auto server = echoServer();
+    AsyncHttpRequest request{AsyncHttpRequest::Polled{}, "testViews"};
+
+    const AsyncHttpRequest::HeaderView first[] { { "X-Test", "a" } };
+    ASSERT_TRUE(request.startView(server.url("/echo"), HTTP_METHOD_POST, first, bytes("one")));
+    ASSERT_TRUE(finish(request));
+
+    const AsyncHttpRequest::HeaderView second[] { { "X-Test", "b" } };
+    ASSERT_TRUE(request.retryView(std::nullopt, std::nullopt, second, bytes("two")));
+    ASSERT_TRUE(finish(request));
+    ASSERT_TRUE(request.result());
+    EXPECT_EQ(std::string_view{request.buffer()}, "POST b two");
+    EXPECT_EQ(request.reuseHits(), 1);
+}
+
+TEST(AsyncHttpViews, JoinsRepeatedHeaderNames)
+{
+    auto server = echoServer();
+    AsyncHttpRequest request{AsyncHttpRequest::Polled{}, "testViews"};
+
+    const AsyncHttpRequest::HeaderView headers[] { { "X-Test", "a" }, { "X-Other", "c" }, { "x-test", "b" }, { "X-TEST", "d" } };
+    ASSERT_TRUE(request.startView(server.url("/echo"), HTTP_METHOD_GET, headers));
+    ASSERT_TRUE(finish(request));
+    ASSERT_TRUE(request.result());
+    EXPECT_EQ(std::string_view{request.buffer()}, "GET a, b, d ");
+}
+
+TEST(AsyncHttpViews, ReceivesIntoTheResponseBuffer)
+{
+    auto server = echoServer();
+    AsyncHttpRequest request{AsyncHttpRequest::Polled{}, "testViews"};
+
+    std::array<char, 100> responseBuffer{};
+    ASSERT_TRUE(request.startView(server.url("/bytes/100"), HTTP_METHOD_GET, {}, {}, 0, {}, {}, responseBuffer));
+    ASSERT_TRUE(finish(request));
+    ASSERT_TRUE(request.result());
+    EXPECT_EQ(request.responseSize(), 100);
+    EXPECT_TRUE(request.buffer().empty());
+    EXPECT_EQ(std::string_view(responseBuffer.data(), responseBuffer.size()), LoopbackServer::pattern(100));
+}
+
+TEST(AsyncHttpViews, FailsWhenTheResponseBufferIsTooSmall)
+{
+    auto server = echoServer();
+    AsyncHttpRequest request{AsyncHttpRequest::Polled{}, "testViews"};
+
+    std::array<char, 50> responseBuffer{};
+    ASSERT_TRUE(request.startView(server.url("/bytes/100"), HTTP_METHOD_GET, {}, {}, 0, {}, {}, responseBuffer));
+    ASSERT_TRUE(finish(request));
+    // the declared Content-Length already exceeds the buffer
+    ASSERT_FALSE(request.result());
+    EXPECT_EQ(request.result().error(), "http request failed: response too large (100 bytes declared, limit 50)");
+}
@@ -0,0 +1,51 @@
+// system includes
+#include <memory>
+#include <vector>
+
+// 3rdparty lib includes
+#include <gtest/gtest.h>
+
+// local includes
+#include "asynchttprequest.h"
+#include "asynchttpworker.h"
+#include "loopbackserver.h"
+
+using namespace std::chrono_literals;
+
+TEST(AsyncHttpWorker, RunsRequestsOfSeveralInstances)
+{
+    LoopbackServer server;
+    AsyncHttpWorker worker{"testWorker", espcpputils::CoreAffinity::Both, 4096, 2};
+
+    std::vector<std::unique_ptr<AsyncHttpRequest>> requests;
+    for (int i = 0; i < 4; i++)
+        requests.push_back(std::make_unique<AsyncHttpRequest>(worker, "testWorkerRequest"));
+
+    for (std::size_t i = 0; i < requests.size(); i++)
+        ASSERT_TRUE(requests[i]->start(server.url("/bytes/" + std::to_string(100 * (i + 1)))));
+
+    for (std::size_t i = 0; i < requests.size(); i++)
+    {
+        ASSERT_TRUE(requests[i]->waitFinished(10s));
+        EXPECT_TRUE(requests[i]->result());
+        EXPECT_EQ(std::string_view{requests[i]->buffer()}, LoopbackServer::pattern(100 * (i + 1)));
+    }
+}
+
+TEST(AsyncHttpWorker, EndsTasksBeforeItIsDestroyed)
+{
+    LoopbackServer server;
+
+    // the last task ending used to touch the worker after endTasks() returned
+    for (int i = 0; i < 20; i++)
+    {
+        AsyncHttpWorker worker{"testWorker", espcpputils::CoreAffinity::Both, 4096, 4};
+        {
+            AsyncHttpRequest request{worker, "testWorkerRequest"};
+            ASSERT_TRUE(request.start(server.url("/bytes/100")));
+            ASSERT_TRUE(request.waitFinished(10s));
+        }
+        ASSERT_TRUE(worker.endTasks());
+        EXPECT_FALSE(worker.tasksRunning());
+    }
+}